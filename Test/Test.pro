@@ -22,6 +22,8 @@ SOURCES += \
         ../src/tracking.cpp \
         ../src/videoreader.cpp \
         ../src/Hungarian.cpp \
+        ../src/assignment.cpp \
+        ../src/trackstore.cpp \
         ../src/autolevel.cpp \
         ../src/data.cpp \
 
@@ -34,6 +36,8 @@ HEADERS += \
         ../src/tracking.h \
         ../src/videoreader.h \
         ../src/Hungarian.h \
+        ../src/assignment.h \
+        ../src/trackstore.h \
         ../src/autolevel.h \
         ../src/data.h \
         /usr/include/gtest/gtest.h \
@@ -63,6 +63,55 @@ TEST_F(TrackingTest, CurvatureCenter) {
   EXPECT_NEAR(test.y, 2, 0.005);
 }
 
+TEST_F(TrackingTest, Curvature) {
+  Tracking tracking("", "");
+  Tracking serialTracking("", "");
+  QMap<QString, QString> params{{"backend", "1"}};
+  serialTracking.updatingParameters(params);
+
+  Mat image = Mat::zeros(600, 300, CV_8U);
+  ellipse(image, Point(150, 300), Size(120, 280), 20, 0, 360, Scalar(255), FILLED);
+  circle(image, Point(150, 300), 40, Scalar(0), FILLED);
+  Point2d center(-50.5, 400.25);
+
+  // Serial reference
+  double d = 0, count = 0;
+  for (int y = 0; y < image.rows; y++) {
+    for (int x = 0; x < image.cols; x++) {
+      if (image.at<uchar>(y, x) == 255) {
+        d += sqrt(pow(center.x - y, 2) + pow(center.y - x, 2));
+        count++;
+      }
+    }
+  }
+  double reference = count / d;
+
+  double serial = serialTracking.curvature(center, image);
+  double parallel = tracking.curvature(center, image);
+  EXPECT_NEAR(serial, reference, 1e-12 * reference);
+  EXPECT_EQ(serial, parallel);
+}
+
+TEST_F(TrackingTest, CurvatureThreads) {
+  Tracking tracking("", "");
+
+  // Tall image split in several ranges, the rows of the worker threads are summed with the rows of the calling thread
+  Mat image = Mat::zeros(2000, 200, CV_8U);
+  ellipse(image, Point(100, 1000), Size(90, 980), 5, 0, 360, Scalar(255), FILLED);
+  Point2d center(-30.5, 120.25);
+
+  int threads = cv::getNumThreads();
+  cv::setNumThreads(1);
+  double serial = tracking.curvature(center, image);
+  cv::setNumThreads(8);
+  double parallel = tracking.curvature(center, image);
+  double inObjectLoop = tracking.curvature(center, image, false);
+  cv::setNumThreads(threads);
+  EXPECT_EQ(serial, parallel);
+  EXPECT_EQ(serial, inObjectLoop);
+  EXPECT_GT(serial, 0);
+}
+
 // Registration test
 TEST_F(TrackingTest, RegistrationMethod0Lena) {
   UMat imageReference, registered, diff;
@@ -229,6 +278,31 @@ TEST_F(TrackingTest, RegistrationMethod2Dual) {
   EXPECT_EQ(countNonZero(diff), 0);*/
 }
 
+TEST_F(TrackingTest, RegistrationMat) {
+  // The CPU backends register the Mat images directly, the result is the one of the UMat images on the CPU
+  bool useOpenCL = cv::ocl::useOpenCL();
+  cv::ocl::setUseOpenCL(false);
+  Mat imageReference = imread("../dataSet/len_full.jpg", IMREAD_GRAYSCALE);
+  Mat padded;
+  copyMakeBorder(imageReference, padded, 50, 50, 50, 50, BORDER_CONSTANT);
+  Mat H = (Mat_<float>(2, 3) << 1.0, 0.0, -20, 0.0, 1.0, 10);
+  Mat shifted;
+  warpAffine(padded, shifted, H, padded.size());
+
+  for (int method : {0, 1}) {
+    Mat registered = shifted.clone();
+    UMat registeredUMat, paddedUMat;
+    shifted.copyTo(registeredUMat);
+    padded.copyTo(paddedUMat);
+    Tracking::registration(padded, registered, method);
+    Tracking::registration(paddedUMat, registeredUMat, method);
+    EXPECT_EQ(registered.type(), CV_8U);
+    EXPECT_EQ(norm(registered, registeredUMat.getMat(ACCESS_READ), NORM_INF), 0);
+  }
+  EXPECT_EQ(padded.type(), CV_8U);
+  cv::ocl::setUseOpenCL(useOpenCL);
+}
+
 TEST_F(TrackingTest, Module) {
   Tracking tracking("", "");
   EXPECT_EQ(tracking.modul(0), 0);
@@ -272,6 +346,83 @@ TEST_F(TrackingTest, Divide) {
   EXPECT_EQ(tracking.divide(1, 0), 0);
 }
 
+TEST_F(TrackingTest, AdaptiveBinarisation) {
+  // Horizontal illumination gradient with two objects, one at each side of the image
+  Mat image(200, 200, CV_8U);
+  for (int y = 0; y < image.rows; y++) {
+    for (int x = 0; x < image.cols; x++) {
+      image.at<uchar>(y, x) = static_cast<uchar>(0.75 * x);
+    }
+  }
+  Mat left = image(Rect(20, 50, 10, 10));
+  left += Scalar(40);
+  Mat right = image(Rect(170, 120, 10, 10));
+  right += Scalar(40);
+
+  UMat global, adaptive;
+  image.copyTo(global);
+  image.copyTo(adaptive);
+  Tracking::binarisation(global, 'b', 60);
+  EXPECT_GT(countNonZero(global), 200);
+
+  Tracking::adaptiveBinarisation(adaptive, 15, 20);
+  EXPECT_EQ(countNonZero(adaptive), 200);
+  EXPECT_EQ(countNonZero(adaptive(Rect(20, 50, 10, 10))), 100);
+  EXPECT_EQ(countNonZero(adaptive(Rect(170, 120, 10, 10))), 100);
+}
+
+TEST_F(TrackingTest, BinarisationBackends) {
+  Mat image(200, 200, CV_8U);
+  randu(image, Scalar(0), Scalar(255));
+
+  // The OpenCL activation is stored per thread and restored at the end of the test
+  bool useOpenCL = cv::ocl::useOpenCL();
+  for (int backend = 0; backend < 3; backend++) {
+    cv::ocl::setUseOpenCL(backend == 2);
+    bool isParallel = (backend != 1);
+
+    Mat globalMat = image.clone();
+    UMat globalUMat;
+    image.copyTo(globalUMat);
+    Tracking::binarisation(globalMat, 'b', 128);
+    Tracking::binarisation(globalUMat, 'b', 128);
+    EXPECT_EQ(norm(globalMat, globalUMat.getMat(ACCESS_READ), NORM_INF), 0);
+
+    Mat adaptiveMat = image.clone();
+    UMat adaptiveUMat;
+    image.copyTo(adaptiveUMat);
+    Tracking::adaptiveBinarisation(adaptiveMat, 7, 5, isParallel);
+    Tracking::adaptiveBinarisation(adaptiveUMat, 7, 5, isParallel);
+    EXPECT_EQ(norm(adaptiveMat, adaptiveUMat.getMat(ACCESS_READ), NORM_INF), 0);
+  }
+  cv::ocl::setUseOpenCL(useOpenCL);
+}
+
+TEST_F(TrackingTest, AdaptiveBinarisationSubtraction) {
+  // The fused subtraction gives the binary image of the subtraction followed by the adaptive threshold
+  Mat image(150, 220, CV_8U), background(150, 220, CV_8U);
+  randu(image, Scalar(0), Scalar(255));
+  randu(background, Scalar(0), Scalar(255));
+
+  for (bool isDarkObjects : {true, false}) {
+    const Mat &minuend = (isDarkObjects) ? background : image;
+    const Mat &subtrahend = (isDarkObjects) ? image : background;
+    Mat reference;
+    subtract(minuend, subtrahend, reference);
+    Tracking::adaptiveBinarisation(reference, 9, 4);
+
+    Mat fused;
+    Tracking::adaptiveBinarisation(minuend, subtrahend, fused, 9, 4);
+    EXPECT_EQ(norm(fused, reference, NORM_INF), 0);
+
+    UMat minuendUMat, subtrahendUMat, fusedUMat;
+    minuend.copyTo(minuendUMat);
+    subtrahend.copyTo(subtrahendUMat);
+    Tracking::adaptiveBinarisation(minuendUMat, subtrahendUMat, fusedUMat, 9, 4, false);
+    EXPECT_EQ(norm(fusedUMat.getMat(ACCESS_READ), reference, NORM_INF), 0);
+  }
+}
+
 TEST_F(TrackingTest, Reassignement) {
   Tracking tracking("", "");
 
@@ -455,6 +606,94 @@ TEST_F(TrackingTest, Cleaning) {
   EXPECT_EQ(lost, lostComp);
 }
 
+TEST_F(TrackingTest, ReassignmentCleaningLinear) {
+  Tracking tracking("", "");
+  RNG rng(13);
+
+  // Previous implementations, quadratic in the number of objects
+  auto reassignmentReference = [](const vector<Point3d> &past, const vector<Point3d> &input, const vector<int> &assignment) {
+    vector<Point3d> tmp = past;
+    for (size_t i = 0; i < past.size(); i++) {
+      if (assignment[i] != -1) {
+        tmp[i] = input[assignment[i]];
+      }
+    }
+    for (int j = 0; j < int(input.size()); j++) {
+      if (find(assignment.begin(), assignment.end(), j) == assignment.end()) {
+        tmp.push_back(input[j]);
+      }
+    }
+    return tmp;
+  };
+  auto cleaningReference = [](const vector<int> &occluded, vector<int> &lostCounter, vector<int> &id, vector<vector<Point3d>> &input, double maximalTime) {
+    vector<int> counter(lostCounter.size(), 0);
+    for (auto &a : occluded) {
+      counter[a] = lostCounter[a] + 1;
+    }
+    for (size_t i = counter.size(); i > 0; i--) {
+      if (counter[i - 1] > maximalTime) {
+        counter.erase(counter.begin() + i - 1);
+        id.erase(id.begin() + i - 1);
+        for (auto &a : input) {
+          if (i - 1 < a.size()) {
+            a.erase(a.begin() + i - 1);
+          }
+        }
+      }
+    }
+    lostCounter = counter;
+  };
+
+  for (int test = 0; test < 200; test++) {
+    int n = rng.uniform(0, 12);
+    int m = rng.uniform(0, 12);
+    vector<Point3d> past(n), input(m);
+    for (auto &a : past) {
+      a = Point3d(rng.uniform(0, 100), rng.uniform(0, 100), 0);
+    }
+    for (auto &a : input) {
+      a = Point3d(rng.uniform(0, 100), rng.uniform(0, 100), 1);
+    }
+
+    // Each detection is assigned to at most one previous object
+    vector<int> columns(m);
+    iota(columns.begin(), columns.end(), 0);
+    randShuffle(columns, 1, &rng);
+    vector<int> assignment(n, -1), occluded;
+    for (int i = 0; i < n; i++) {
+      if (i < m && rng.uniform(0, 4) != 0) {
+        assignment[i] = columns[i];
+      }
+      else {
+        occluded.push_back(i);
+      }
+    }
+    EXPECT_EQ(tracking.reassignment(past, input, assignment), reassignmentReference(past, input, assignment));
+
+    // The input vectors can be shorter or longer than the counters
+    vector<int> lost(n), id(n);
+    for (int i = 0; i < n; i++) {
+      lost[i] = rng.uniform(0, 4);
+      id[i] = 10 * i;
+    }
+    vector<vector<Point3d>> objects(3);
+    for (auto &a : objects) {
+      a.resize(rng.uniform(0, n + 3));
+      for (auto &b : a) {
+        b = Point3d(rng.uniform(0, 100), 0, 0);
+      }
+    }
+    vector<int> lostReference = lost, idReference = id;
+    vector<vector<Point3d>> objectsReference = objects;
+    double maximalTime = rng.uniform(0, 4);
+    tracking.cleaning(occluded, lost, id, objects, maximalTime);
+    cleaningReference(occluded, lostReference, idReference, objectsReference, maximalTime);
+    EXPECT_EQ(lost, lostReference);
+    EXPECT_EQ(id, idReference);
+    EXPECT_EQ(objects, objectsReference);
+  }
+}
+
 TEST_F(TrackingTest, Information) {
   Tracking tracking("", "");
   vector<double> info, test;
@@ -487,6 +726,533 @@ TEST_F(TrackingTest, InformationOrientation) {
   EXPECT_EQ(round(test.at(2) * 1000), round(1000 * (M_PI)));
 }
 
+TEST_F(TrackingTest, ObjectPositionCloseObjects) {
+  Tracking tracking("", "");
+
+  // A square inside the bounding box of a L-shaped object
+  Mat lShape = Mat::zeros(100, 100, CV_8U);
+  rectangle(lShape, Rect(10, 10, 50, 10), Scalar(255), FILLED);
+  rectangle(lShape, Rect(10, 10, 10, 50), Scalar(255), FILLED);
+  Mat square = Mat::zeros(100, 100, CV_8U);
+  rectangle(square, Rect(30, 30, 20, 20), Scalar(255), FILLED);
+  Mat frame = lShape | square;
+
+  vector<vector<Point3d>> out = tracking.objectPosition(frame, 10, 10000);
+  ASSERT_EQ(out[2].size(), size_t(2));
+
+  vector<Point2d> expected;
+  for (const Mat &object : {lShape, square}) {
+    Moments moment = moments(object, true);
+    expected.push_back(Point2d(moment.m10 / moment.m00, moment.m01 / moment.m00));
+  }
+  for (const auto &a : out[2]) {
+    double distance = std::min(norm(Point2d(a.x, a.y) - expected[0]), norm(Point2d(a.x, a.y) - expected[1]));
+    EXPECT_LT(distance, 1e-6);
+  }
+
+  // Same result when the buffer is reused
+  vector<vector<Point3d>> outReused = tracking.objectPosition(frame, 10, 10000);
+  EXPECT_EQ(out[2], outReused[2]);
+  EXPECT_EQ(out[3], outReused[3]);
+}
+
+TEST_F(TrackingTest, ObjectPositionConnectedComponents) {
+  Tracking tracking("", "");
+
+  Mat frame = Mat::zeros(100, 100, CV_8U);
+  rectangle(frame, Rect(10, 10, 50, 10), Scalar(255), FILLED);
+  rectangle(frame, Rect(10, 10, 10, 50), Scalar(255), FILLED);
+  rectangle(frame, Rect(30, 30, 20, 20), Scalar(255), FILLED);
+  rectangle(frame, Rect(80, 80, 2, 2), Scalar(255), FILLED);
+
+  vector<vector<Point3d>> contours = tracking.objectPosition(frame, 10, 10000, 0);
+  vector<vector<Point3d>> components = tracking.objectPosition(frame, 10, 10000, 1);
+  ASSERT_EQ(components[2].size(), size_t(2));
+  ASSERT_EQ(contours[2].size(), size_t(2));
+
+  // Same objects, the area is the number of pixels
+  vector<double> areas;
+  for (size_t i = 0; i < components[2].size(); i++) {
+    size_t j = (norm(components[2][i] - contours[2][0]) < norm(components[2][i] - contours[2][1])) ? 0 : 1;
+    EXPECT_NEAR(components[2][i].x, contours[2][j].x, 1e-9);
+    EXPECT_NEAR(components[2][i].y, contours[2][j].y, 1e-9);
+    EXPECT_EQ(components[3][i].z, contours[3][j].z);
+    areas.push_back(components[3][i].y);
+  }
+  sort(areas.begin(), areas.end());
+  EXPECT_EQ(areas, vector<double>({400, 900}));
+}
+
+TEST_F(TrackingTest, ObjectPositionParallel) {
+  Tracking tracking("", "");
+  Tracking serialTracking("", "");
+  QMap<QString, QString> params{{"backend", "1"}};
+  serialTracking.updatingParameters(params);
+
+  // Objects of different sizes and orientations
+  Mat frame = Mat::zeros(600, 600, CV_8U);
+  RNG rng(42);
+  for (int y = 30; y < 600; y += 60) {
+    for (int x = 30; x < 600; x += 60) {
+      ellipse(frame, Point(x, y), Size(rng.uniform(5, 25), rng.uniform(3, 10)), rng.uniform(0., 360.), 0, 360, Scalar(255), FILLED);
+    }
+  }
+
+  for (int detector = 0; detector < 2; detector++) {
+    vector<vector<Point3d>> serial = serialTracking.objectPosition(frame, 10, 10000, detector);
+    vector<vector<Point3d>> parallel = tracking.objectPosition(frame, 10, 10000, detector);
+    ASSERT_EQ(serial[2].size(), size_t(100));
+    for (size_t k = 0; k < 4; k++) {
+      EXPECT_EQ(serial[k], parallel[k]);
+    }
+  }
+}
+
+TEST_F(TrackingTest, ObjectDirectionSkewness) {
+  Tracking tracking("", "");
+
+  // Triangle with its base at the left, the distribution is skewed to the right
+  Mat image = Mat::zeros(50, 100, CV_8U);
+  vector<Point> triangle = {Point(10, 5), Point(10, 45), Point(90, 25)};
+  fillConvexPoly(image, triangle, Scalar(255));
+  vector<double> information = {0, 0, 0};
+  EXPECT_TRUE(tracking.objectDirection(image, information));
+  EXPECT_DOUBLE_EQ(information[2], M_PI);
+
+  Mat mirrored;
+  flip(image, mirrored, 1);
+  information = {0, 0, 0};
+  EXPECT_FALSE(tracking.objectDirection(mirrored, information));
+  EXPECT_DOUBLE_EQ(information[2], 0);
+
+  information = {0, 0, 0};
+  EXPECT_FALSE(tracking.objectDirection(Mat::zeros(50, 100, CV_8U), information));
+}
+
+TEST_F(TrackingTest, ObjectPositionHeadTail) {
+  Tracking tracking("", "");
+
+  // Triangle with its wider part at the left, the head is at the left and the object points to the left
+  Mat frame = Mat::zeros(200, 200, CV_8U);
+  fillConvexPoly(frame, vector<Point>({Point(50, 55), Point(50, 95), Point(130, 75)}), Scalar(255));
+  vector<vector<Point3d>> out = tracking.objectPosition(frame, 10, 10000);
+  ASSERT_EQ(out[2].size(), size_t(1));
+  EXPECT_LT(out[0][0].x, out[2][0].x);
+  EXPECT_GT(out[1][0].x, out[2][0].x);
+  EXPECT_NEAR(out[0][0].y, 75, 0.5);
+  EXPECT_NEAR(out[1][0].y, 75, 0.5);
+  EXPECT_NEAR(out[2][0].z, M_PI, 0.05);
+  EXPECT_NEAR(out[0][0].z, M_PI, 0.05);
+  EXPECT_NEAR(out[1][0].z, M_PI, 0.05);
+
+  // Same triangle pointing upward
+  Mat rotated;
+  transpose(frame, rotated);
+  out = tracking.objectPosition(rotated, 10, 10000);
+  ASSERT_EQ(out[2].size(), size_t(1));
+  EXPECT_LT(out[0][0].y, out[2][0].y);
+  EXPECT_GT(out[1][0].y, out[2][0].y);
+  EXPECT_NEAR(out[2][0].z, 0.5 * M_PI, 0.05);
+  EXPECT_NEAR(out[0][0].z, 0.5 * M_PI, 0.05);
+  EXPECT_NEAR(out[1][0].z, 0.5 * M_PI, 0.05);
+}
+
+TEST_F(TrackingTest, ObjectPositionTiled) {
+  // Objects crossing the boundaries between stripes, a U shape connected only in the last stripe
+  // and a diagonal line connected only by the corners of its pixels
+  Mat frame = Mat::zeros(600, 400, CV_8U);
+  RNG rng(7);
+  for (int i = 0; i < 20; i++) {
+    ellipse(frame, Point(rng.uniform(20, 380), rng.uniform(20, 580)), Size(rng.uniform(5, 40), rng.uniform(3, 15)), rng.uniform(0., 360.), 0, 360, Scalar(255), FILLED);
+  }
+  rectangle(frame, Rect(300, 100, 5, 200), Scalar(255), FILLED);
+  rectangle(frame, Rect(330, 100, 5, 200), Scalar(255), FILLED);
+  rectangle(frame, Rect(300, 295, 35, 5), Scalar(255), FILLED);
+  line(frame, Point(10, 300), Point(200, 490), Scalar(255), 1, LINE_8);
+
+  for (int backend : {0, 1}) {
+    Tracking tracking("", "");
+    QMap<QString, QString> params{{"backend", QString::number(backend)}};
+    tracking.updatingParameters(params);
+    vector<vector<Point3d>> full = tracking.objectPosition(frame, 10, 100000, 1);
+    vector<vector<Point3d>> tiled = tracking.objectPosition(frame, 10, 100000, 2);
+    ASSERT_GT(full[2].size(), size_t(1));
+    for (size_t i = 0; i < 4; i++) {
+      EXPECT_EQ(tiled[i], full[i]);
+    }
+  }
+}
+
+TEST_F(TrackingTest, CoarseWindows) {
+  Tracking tracking("", "");
+
+  // Dark objects on a textured light background
+  Mat background(400, 500, CV_8U);
+  RNG rng(3);
+  rng.fill(background, RNG::UNIFORM, 180, 220);
+  Mat frame = background.clone();
+  for (int i = 0; i < 6; i++) {
+    ellipse(frame, Point(rng.uniform(20, 480), rng.uniform(20, 380)), Size(rng.uniform(5, 20), rng.uniform(3, 8)), rng.uniform(0., 360.), 0, 360, Scalar(60), FILLED);
+  }
+  int margin = 5;
+  vector<Rect> windows;
+  ASSERT_TRUE(tracking.coarseWindows(frame, background, true, 50, 8, margin, windows));
+  ASSERT_FALSE(windows.empty());
+  for (size_t i = 0; i < windows.size(); i++) {
+    for (size_t j = i + 1; j < windows.size(); j++) {
+      EXPECT_EQ((windows[i] & windows[j]).area(), 0);
+    }
+  }
+
+  // Every pixel above the threshold is inside a window, at least margin pixels from its edges
+  Mat difference;
+  subtract(background, frame, difference);
+  Rect image(0, 0, frame.cols, frame.rows);
+  for (int y = 0; y < frame.rows; y++) {
+    for (int x = 0; x < frame.cols; x++) {
+      if (difference.at<uchar>(y, x) > 50) {
+        Rect neighborhood = Rect(x - margin, y - margin, 2 * margin + 1, 2 * margin + 1) & image;
+        EXPECT_TRUE(any_of(windows.begin(), windows.end(), [&neighborhood](const Rect &a) { return (neighborhood & a) == neighborhood; }));
+      }
+    }
+  }
+
+  // The whole image is a candidate, it has to be processed entirely
+  EXPECT_FALSE(tracking.coarseWindows(Mat::zeros(frame.size(), CV_8U), background, true, 50, 8, margin, windows));
+  EXPECT_TRUE(windows.empty());
+}
+
+TEST_F(TrackingTest, MergeWindows) {
+  // Previous merging, the overlapping windows are merged pairwise until they are disjoint
+  auto reference = [](vector<Rect> windows) {
+    for (bool isMerged = true; isMerged;) {
+      isMerged = false;
+      for (size_t i = 0; i < windows.size(); i++) {
+        for (size_t j = i + 1; j < windows.size(); j++) {
+          if ((windows[i] & windows[j]).area() > 0) {
+            windows[i] |= windows[j];
+            windows.erase(windows.begin() + j);
+            isMerged = true;
+            j = i;
+          }
+        }
+      }
+    }
+    return windows;
+  };
+  auto sorted = [](vector<Rect> windows) {
+    sort(windows.begin(), windows.end(), [](const Rect &a, const Rect &b) { return make_tuple(a.x, a.y, a.width, a.height) < make_tuple(b.x, b.y, b.width, b.height); });
+    return windows;
+  };
+
+  RNG rng(17);
+  for (int i = 0; i < 500; i++) {
+    vector<Rect> windows(rng.uniform(0, 40));
+    for (auto &a : windows) {
+      a = Rect(rng.uniform(0, 200), rng.uniform(0, 200), rng.uniform(1, 40), rng.uniform(1, 40));
+    }
+    vector<Rect> expected = reference(windows);
+    ASSERT_TRUE(mergeWindows(windows, Size(1000, 1000)));
+    EXPECT_EQ(sorted(windows), sorted(expected));
+  }
+
+  // A chain of windows merged in one window
+  vector<Rect> windows = {Rect(0, 0, 10, 10), Rect(20, 5, 10, 10), Rect(5, 8, 20, 4), Rect(28, 14, 5, 5)};
+  ASSERT_TRUE(mergeWindows(windows, Size(1000, 1000)));
+  EXPECT_EQ(windows, vector<Rect>({Rect(0, 0, 33, 19)}));
+}
+
+/**
+ * @brief Expects the same objects in any order. The positions detected in a window are shifted by its corner, they can differ by the rounding from the positions detected in the whole image.
+ */
+void expectSameDetections(const TrackStore &detections, const TrackStore &expected) {
+  auto sorted = [](const TrackStore &out) {
+    vector<vector<double>> objects;
+    for (size_t i = 0; i < out.size(); i++) {
+      vector<double> object;
+      for (const auto &a : out.fields) {
+        object.push_back(a[i]);
+      }
+      objects.push_back(object);
+    }
+    sort(objects.begin(), objects.end());
+    return objects;
+  };
+  vector<vector<double>> a = sorted(detections), b = sorted(expected);
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); i++) {
+    for (size_t k = 0; k < a[i].size(); k++) {
+      EXPECT_NEAR(a[i][k], b[i][k], 1e-9 * std::max(1., abs(b[i][k])));
+    }
+  }
+}
+
+TEST_F(TrackingTest, CoarseDetection) {
+  QMap<QString, QString> parameters{{"thresh", "50"}, {"lightBack", "0"}, {"minArea", "10"}, {"maxArea", "100000"}, {"morph", "3"}, {"morphSize", "1"}, {"morphType", "0"}};
+
+  // Few dark objects on a textured light background
+  Mat background(400, 500, CV_8U);
+  RNG rng(9);
+  rng.fill(background, RNG::UNIFORM, 180, 220);
+  Mat frame = background.clone();
+  for (int i = 0; i < 5; i++) {
+    ellipse(frame, Point(rng.uniform(30, 470), rng.uniform(30, 370)), Size(rng.uniform(8, 20), rng.uniform(3, 8)), rng.uniform(0., 360.), 0, 360, Scalar(60), FILLED);
+  }
+
+  for (int detector : {0, 1}) {
+    parameters.insert("detector", QString::number(detector));
+    Tracking reference("", "");
+    reference.updatingParameters(parameters);
+    Tracking tracking("", "");
+    parameters.insert("coarseScale", "8");
+    tracking.updatingParameters(parameters);
+    parameters.remove("coarseScale");
+
+    // The frame is sparse enough for the coarse detection to process only windows
+    vector<Rect> windows;
+    ASSERT_TRUE(tracking.coarseWindows(frame, background, true, 50, 8, 3, windows));
+
+    // The objects and the binary image are the ones of the whole image
+    Mat referenceFrame = frame.clone(), coarseFrame = frame.clone();
+    reference.processImage(referenceFrame, background);
+    tracking.processImage(coarseFrame, background);
+    ASSERT_GT(reference.m_detections.size(), size_t(1));
+    expectSameDetections(tracking.m_detections, reference.m_detections);
+    EXPECT_EQ(countNonZero(tracking.m_binaryFrame != reference.m_binaryFrame), 0);
+  }
+}
+
+TEST_F(TrackingTest, PredictionWindows) {
+  Tracking tracking("", "");
+
+  // Two objects close enough for their windows to merge and one object on the border of the region of interest
+  Mat frame = Mat::zeros(400, 500, CV_8U);
+  Point offset(20, 10);
+  vector<Point> positions = {Point(100, 100), Point(120, 110), Point(0, 200)};
+  vector<vector<Point3d>> objects(7);
+  for (const auto &a : positions) {
+    for (size_t k = 0; k < 3; k++) {
+      objects[k].push_back(Point3d(a.x, a.y, 0));
+    }
+    objects[3].push_back(Point3d());
+    objects[4].push_back(Point3d(3, 1, 0.5));
+    objects[5].push_back(Point3d(2, 1, 0.5));
+    objects[6].push_back(Point3d(5, 2, 0.5));
+  }
+  int margin = 3;
+  double maxDistance = 10;
+  TrackStore store;
+  store.load(objects);
+  vector<Rect> windows;
+  ASSERT_TRUE(tracking.predictionWindows(store, 2, maxDistance, offset, frame.size(), margin, windows));
+  ASSERT_EQ(windows.size(), size_t(2));
+  EXPECT_EQ((windows[0] & windows[1]).area(), 0);
+
+  // Every pixel that an object can reach is inside a window, at least margin pixels from its edges
+  Rect image(0, 0, frame.cols, frame.rows);
+  int radius = int(maxDistance) + 12 + margin;
+  for (const auto &a : positions) {
+    Rect reach = Rect(a.x + offset.x - radius, a.y + offset.y - radius, 2 * radius + 1, 2 * radius + 1) & image;
+    EXPECT_TRUE(any_of(windows.begin(), windows.end(), [&reach](const Rect &b) { return (reach & b) == reach; }));
+  }
+
+  // The windows cover the whole image, it has to be processed entirely
+  EXPECT_FALSE(tracking.predictionWindows(store, 2, 500, offset, frame.size(), margin, windows));
+  EXPECT_TRUE(windows.empty());
+}
+
+TEST_F(TrackingTest, PredictionWindowsDetection) {
+  QMap<QString, QString> parameters{{"thresh", "50"}, {"lightBack", "0"}, {"minArea", "10"}, {"maxArea", "100000"}, {"morph", "3"}, {"morphSize", "1"}, {"morphType", "0"}, {"spot", "2"}, {"maxDist", "20"}};
+  Tracking reference("", "");
+  reference.updatingParameters(parameters);
+  parameters.insert("nObject", "3");
+  Tracking tracking("", "");
+  tracking.updatingParameters(parameters);
+
+  Mat background(600, 800, CV_8U);
+  RNG rng(21);
+  rng.fill(background, RNG::UNIFORM, 180, 220);
+  auto draw = [&background](const Point &shift) {
+    Mat frame = background.clone();
+    ellipse(frame, Point(80, 80) + shift, Size(15, 6), 0, 0, 360, Scalar(60), FILLED);
+    ellipse(frame, Point(300, 200) + shift, Size(15, 6), 40, 0, 360, Scalar(60), FILLED);
+    ellipse(frame, Point(500, 400) + shift, Size(15, 6), 100, 0, 360, Scalar(60), FILLED);
+    return frame;
+  };
+
+  // The objects of the first image are the tracked objects
+  Mat frame = draw(Point(0, 0));
+  tracking.processImage(frame, background);
+  ASSERT_EQ(tracking.m_detections.size(), size_t(3));
+  tracking.m_tracks = tracking.m_detections;
+  vector<Rect> windows;
+  ASSERT_TRUE(tracking.predictionWindows(tracking.m_tracks, 2, 20, Point(0, 0), frame.size(), 3, windows));
+
+  // The objects moved less than the maximal distance, the windows give the objects of the whole image
+  frame = draw(Point(4, 3));
+  Mat referenceFrame = frame.clone();
+  tracking.processImage(frame, background);
+  reference.processImage(referenceFrame, background);
+  expectSameDetections(tracking.m_detections, reference.m_detections);
+
+  // A new object appears in the window of the first object and another one far from the windows. The number of objects
+  // found in the windows differs, the whole image is processed again and both new objects are detected.
+  frame = draw(Point(4, 3));
+  circle(frame, Point(80, 115), 6, Scalar(60), FILLED);
+  circle(frame, Point(700, 520), 6, Scalar(60), FILLED);
+  referenceFrame = frame.clone();
+  tracking.processImage(frame, background);
+  reference.processImage(referenceFrame, background);
+  ASSERT_EQ(reference.m_detections.size(), size_t(5));
+  expectSameDetections(tracking.m_detections, reference.m_detections);
+}
+
+TEST_F(TrackingTest, ChangeDrivenProcessing) {
+  QMap<QString, QString> parameters{{"thresh", "50"}, {"lightBack", "0"}, {"minArea", "10"}, {"maxArea", "100000"}, {"morph", "3"}, {"morphSize", "1"}, {"morphType", "0"}};
+  auto sorted = [](const TrackStore &out) {
+    vector<array<double, 4>> objects;
+    for (size_t i = 0; i < out.size(); i++) {
+      objects.push_back({out.fields[TrackStore::xBody][i], out.fields[TrackStore::yBody][i], out.fields[TrackStore::tBody][i], out.fields[TrackStore::areaBody][i]});
+    }
+    sort(objects.begin(), objects.end());
+    return objects;
+  };
+
+  for (int detector : {0, 1}) {
+    parameters.insert("detector", QString::number(detector));
+    Tracking reference("", "");
+    reference.updatingParameters(parameters);
+    Tracking tracking("", "");
+    parameters.insert("changeTile", "16");
+    tracking.updatingParameters(parameters);
+    parameters.remove("changeTile");
+
+    // A static object, a moving object and an object appearing on a noisy background
+    Mat background(300, 400, CV_8U);
+    RNG rng(5);
+    rng.fill(background, RNG::UNIFORM, 180, 220);
+    Mat noise(background.size(), CV_8U);
+    for (int i = 0; i < 10; i++) {
+      Mat frame;
+      rng.fill(noise, RNG::UNIFORM, 0, 4);
+      add(background, noise, frame);
+      ellipse(frame, Point(80, 80), Size(20, 8), 30, 0, 360, Scalar(60), FILLED);
+      ellipse(frame, Point(60 + 25 * i, 200), Size(15, 6), 10 * i, 0, 360, Scalar(60), FILLED);
+      if (i > 5) {
+        circle(frame, Point(300, 60), 10, Scalar(60), FILLED);
+      }
+      Mat referenceFrame = frame.clone();
+      reference.processImage(referenceFrame, background);
+      tracking.processImage(frame, background);
+      EXPECT_EQ(sorted(tracking.m_detections), sorted(reference.m_detections));
+      EXPECT_EQ(countNonZero(tracking.m_binaryFrame != reference.m_binaryFrame), 0);
+    }
+  }
+}
+
+TEST_F(TrackingTest, ObjectPositionFeatures) {
+  Tracking tracking("", "");
+
+  Mat frame = Mat::zeros(200, 200, CV_8U);
+  fillConvexPoly(frame, vector<Point>({Point(50, 55), Point(50, 95), Point(130, 75)}), Scalar(255));
+  circle(frame, Point(150, 150), 15, Scalar(255), FILLED);
+  for (int detector : {0, 1}) {
+    vector<vector<Point3d>> all = tracking.objectPosition(frame, 10, 10000, detector);
+    vector<vector<Point3d>> out = tracking.objectPosition(frame, 10, 10000, detector, Tracking::FeatureBody | Tracking::FeatureArea);
+    ASSERT_EQ(out.size(), all.size());
+    ASSERT_EQ(out[2].size(), size_t(2));
+    for (size_t i = 0; i < out[2].size(); i++) {
+      EXPECT_EQ(out[2][i], all[2][i]);
+      EXPECT_EQ(out[3][i].y, all[3][i].y);
+      EXPECT_EQ(out[3][i].x, 0);
+      EXPECT_EQ(out[3][i].z, 0);
+      EXPECT_EQ(out[0][i], Point3d());
+      EXPECT_EQ(out[1][i], Point3d());
+    }
+  }
+
+  EXPECT_EQ(Tracking::featureMask(""), Tracking::FeatureAll);
+  EXPECT_EQ(Tracking::featureMask("body, Area"), Tracking::FeatureBody | Tracking::FeatureArea);
+  EXPECT_EQ(Tracking::featureMask("head,unknown"), Tracking::FeatureHead);
+}
+
+TEST_F(TrackingTest, FeaturesOfCostTerms) {
+  QMap<QString, QString> parameters{{"thresh", "50"}, {"lightBack", "0"}, {"minArea", "10"}, {"maxArea", "100000"}, {"spot", "0"}, {"features", "head"}};
+  Mat background(200, 200, CV_8U, Scalar(200));
+  Mat frame = background.clone();
+  ellipse(frame, Point(100, 100), Size(30, 10), 20, 0, 360, Scalar(60), FILLED);
+
+  // The area and the perimeter used by the cost function are extracted even if they are not selected
+  for (auto [area, perimeter] : vector<pair<int, int>>{{0, 0}, {1, 0}, {0, 1}, {1, 1}}) {
+    parameters.insert("normArea", QString::number(area));
+    parameters.insert("normPerim", QString::number(perimeter));
+    Tracking tracking("", "");
+    tracking.updatingParameters(parameters);
+    Mat image = frame.clone();
+    tracking.processImage(image, background);
+    const TrackStore &out = tracking.m_detections;
+    ASSERT_EQ(out.size(), size_t(1));
+    EXPECT_EQ(out.fields[TrackStore::areaBody][0] > 0, area != 0);
+    EXPECT_EQ(out.fields[TrackStore::perimeterBody][0] > 0, perimeter != 0);
+    EXPECT_EQ(out.fields[TrackStore::curvature][0], 0);
+  }
+}
+
+TEST_F(TrackingTest, ObjectPositionDirection) {
+  Tracking tracking("", "");
+
+  // Triangles with their wide side as head, pointing to the left and to the top of the image
+  Mat left = Mat::zeros(200, 200, CV_8U), top = Mat::zeros(200, 200, CV_8U);
+  fillConvexPoly(left, vector<Point>({Point(50, 55), Point(50, 95), Point(130, 75)}), Scalar(255));
+  fillConvexPoly(top, vector<Point>({Point(80, 50), Point(120, 50), Point(100, 130)}), Scalar(255));
+  for (int detector : {0, 1}) {
+    for (unsigned int features : {Tracking::FeatureAll, Tracking::FeatureBody}) {
+      vector<vector<Point3d>> out = tracking.objectPosition(left, 10, 10000, detector, features);
+      ASSERT_EQ(out[2].size(), size_t(1));
+      EXPECT_NEAR(out[2][0].z, M_PI, 0.02);
+      if (features == Tracking::FeatureAll) {
+        EXPECT_LT(out[0][0].x, out[1][0].x);
+      }
+
+      out = tracking.objectPosition(top, 10, 10000, detector, features);
+      ASSERT_EQ(out[2].size(), size_t(1));
+      EXPECT_NEAR(out[2][0].z, 0.5 * M_PI, 0.02);
+      if (features == Tracking::FeatureAll) {
+        EXPECT_LT(out[0][0].y, out[1][0].y);
+      }
+    }
+  }
+
+  // Same direction as objectDirection on the column sums of the object image
+  vector<double> information = tracking.objectInformation(left);
+  EXPECT_TRUE(tracking.objectDirection(left, information));
+  EXPECT_NEAR(information[2], M_PI, 0.02);
+}
+
+TEST_F(TrackingTest, ObjectPositionAllocations) {
+  Tracking tracking("", "");
+  QMap<QString, QString> params{{"backend", "1"}};
+  tracking.updatingParameters(params);
+
+  Mat frame = Mat::zeros(200, 200, CV_8U);
+  fillConvexPoly(frame, vector<Point>({Point(50, 55), Point(50, 95), Point(130, 75)}), Scalar(255));
+  circle(frame, Point(150, 150), 15, Scalar(255), FILLED);
+  circle(frame, Point(30, 170), 10, Scalar(255), FILLED);
+  for (int detector : {0, 1}) {
+    vector<vector<Point3d>> out;
+    tracking.objectPosition(frame, 10, 10000, detector, Tracking::FeatureAll, out);
+    size_t allocations = tracking.detectionAllocations();
+    EXPECT_GT(allocations, size_t(0));
+
+    // Steady state, the buffers are reused
+    for (int i = 0; i < 3; i++) {
+      tracking.objectPosition(frame, 10, 10000, detector, Tracking::FeatureAll, out);
+    }
+    EXPECT_EQ(tracking.detectionAllocations(), allocations);
+    EXPECT_EQ(out[2], tracking.objectPosition(frame, 10, 10000, detector)[2]);
+  }
+}
+
 TEST_F(TrackingTest, costFunction) {
   Tracking tracking("", "");
   QMap<QString, QString> params;
@@ -668,6 +1434,366 @@ TEST_F(TrackingTest, costFunction) {
   EXPECT_EQ(order, test);
 }
 
+TEST_F(TrackingTest, costFunctionGrid) {
+  Tracking tracking("", "");
+  QMap<QString, QString> params;
+  params["spot"] = "0";
+  tracking.updatingParameters(params);
+
+  // Shuffled objects that moved less than the maximal distance, on a grid of cells smaller than their spacing
+  RNG rng(7);
+  int n = 200;
+  vector<vector<Point3d>> past(4, vector<Point3d>(n)), current(4, vector<Point3d>(n));
+  vector<int> permutation(n);
+  for (int i = 0; i < n; i++) {
+    past[0][i] = Point3d(50 * (i % 20), 50 * (i / 20), 0);
+    permutation[i] = i;
+  }
+  for (int i = 0; i < n; i++) {
+    swap(permutation[i], permutation[rng.uniform(i, n)]);
+  }
+  for (int i = 0; i < n; i++) {
+    current[0][permutation[i]] = past[0][i] + Point3d(rng.uniform(-8., 8.), rng.uniform(-8., 8.), 0);
+  }
+  EXPECT_EQ(tracking.costFunc(past, current, 1, 0, 12, 0, 0), permutation);
+
+  // An object farther than the maximal distance is not assigned
+  current[0][permutation[0]] += Point3d(40, 0, 0);
+  vector<int> order = tracking.costFunc(past, current, 1, 0, 12, 0, 0);
+  EXPECT_EQ(order[0], -1);
+}
+
+TEST_F(TrackingTest, costFunctionComponents) {
+  Tracking tracking("", "");
+
+  // Far apart groups of objects, each with two objects competing for the same object and a lone pair
+  int groupCount = 50;
+  vector<vector<Point3d>> past(4), current(4);
+  vector<int> test;
+  for (int c = 0; c < groupCount; c++) {
+    double x = 100 * c;
+    past[0].insert(past[0].end(), {Point3d(x, 0, 0), Point3d(x + 10, 0, 0), Point3d(x + 50, 0, 0)});
+    current[0].insert(current[0].end(), {Point3d(x + 16, 0, 0), Point3d(x + 6, 0, 0), Point3d(x + 52, 0, 0)});
+    test.insert(test.end(), {3 * c + 1, 3 * c, 3 * c + 2});
+  }
+  past[0].push_back(Point3d(0, 500, 0));
+  test.push_back(-1);
+  past[3] = past[0];
+  current[3] = current[0];
+
+  for (int solver : {0, 1, 2}) {
+    QMap<QString, QString> params{{"spot", "0"}, {"solver", QString::number(solver)}};
+    tracking.updatingParameters(params);
+    EXPECT_EQ(tracking.costFunc(past, current, 1, 0, 12, 0, 0), test);
+  }
+}
+
+TEST_F(TrackingTest, costFunctionTerms) {
+  Tracking tracking("", "");
+  QMap<QString, QString> params{{"spot", "0"}, {"normDist", "1"}, {"normAngle", "0"}, {"normArea", "0"}, {"normPerim", "0"}};
+  tracking.updatingParameters(params);
+
+  // The objects swap their areas, the area term inverts the assignment given by the distance
+  vector<vector<Point3d>> past = {{Point3d(0, 0, 0), Point3d(10, 0, 0)}, {}, {}, {Point3d(0, 10, 0), Point3d(0, 100, 0)}};
+  vector<vector<Point3d>> current = {{Point3d(4, 0, 0), Point3d(6, 0, 0)}, {}, {}, {Point3d(0, 100, 0), Point3d(0, 10, 0)}};
+  vector<int> distanceOrder = {0, 1}, areaOrder = {1, 0};
+
+  // Normalizations of the parameters and other normalizations
+  EXPECT_EQ(tracking.costFunc(past, current, 1, 0, 20, 0, 0), distanceOrder);
+  EXPECT_EQ(tracking.costFunc(past, current, 1, 0, 20, 1, 0), areaOrder);
+
+  params["normArea"] = "1";
+  tracking.updatingParameters(params);
+  EXPECT_EQ(tracking.costFunc(past, current, 1, 0, 20, 1, 0), areaOrder);
+  EXPECT_EQ(tracking.costFunc(past, current, 1, 0, 20, 0, 0), distanceOrder);
+}
+
+TEST_F(TrackingTest, trackStore) {
+  Tracking tracking("", "");
+  QMap<QString, QString> params{{"spot", "2"}};
+  tracking.updatingParameters(params);
+
+  // Three tracked objects, each feature of an object in its own array
+  vector<vector<Point3d>> past(7), current(7);
+  for (int i = 0; i < 3; i++) {
+    for (size_t k = 0; k < past.size(); k++) {
+      past[k].push_back(Point3d(10 * i + k, 100 * i, 0.1 * k));
+    }
+  }
+  TrackStore tracks;
+  tracks.load(past);
+  ASSERT_EQ(tracks.size(), size_t(3));
+  EXPECT_EQ(tracks.fields[TrackStore::xBody], vector<double>({2, 12, 22}));
+  EXPECT_EQ(tracks.fields[TrackStore::tBody], vector<double>(3, 0.2));
+  EXPECT_EQ(tracks.id, vector<int>({0, 1, 2}));
+
+  // The first and third objects move, the second is lost and a new object appears
+  current[0] = {past[0][2], Point3d(500, 500, 0), past[0][0]};
+  for (size_t k = 1; k < current.size(); k++) {
+    current[k] = {past[k][2] + Point3d(1, 0, 0), Point3d(500, 500, 0), past[k][0] + Point3d(1, 0, 0)};
+  }
+  TrackStore detections;
+  detections.load(current);
+  vector<int> order = tracking.costFunc(tracks, detections, 10, 0, 5, 0, 0);
+  EXPECT_EQ(order, vector<int>({2, -1, 0}));
+  EXPECT_EQ(order, tracking.costFunc(past, current, 10, 0, 5, 0, 0));
+
+  int idMax = 2;
+  tracks.update(detections, order, 2, idMax);
+  ASSERT_EQ(tracks.size(), size_t(4));
+  EXPECT_EQ(tracks.fields[TrackStore::xBody], vector<double>({3, 12, 23, 500}));
+  EXPECT_EQ(tracks.id, vector<int>({0, 1, 2, 3}));
+  EXPECT_EQ(idMax, 3);
+
+  // The lost object is removed, the other objects keep their order
+  tracks.clean(order, 0);
+  EXPECT_EQ(tracks.fields[TrackStore::xBody], vector<double>({3, 23, 500}));
+  EXPECT_EQ(tracks.id, vector<int>({0, 2, 3}));
+  EXPECT_EQ(tracks.lost, vector<int>({0, 0, 0}));
+}
+
+TEST_F(TrackingTest, motionGating) {
+  Tracking tracking("", ""), fixed("", "");
+  QMap<QString, QString> params{{"spot", "0"}, {"motionGate", "2"}};
+  tracking.updatingParameters(params);
+  params["motionGate"] = "0";
+  fixed.updatingParameters(params);
+
+  // Two objects crossing at constant velocity, from the second image the detection of the other object is the closest
+  TrackStore tracks, detections;
+  tracks.load({{Point3d(0, 0, 0), Point3d(30, 6, 0)}});
+  int idMax = 1;
+  for (int t = 1; t < 13; t++) {
+    detections.load({{Point3d(10 * t, 0, 0), Point3d(30 - 10 * t, 6, 0)}});
+    vector<int> order = tracking.costFunc(tracks, detections, 1, 0, 50, 0, 0);
+    EXPECT_EQ(order, vector<int>({0, 1}));
+    if (t == 2) {
+      EXPECT_EQ(fixed.costFunc(tracks, detections, 1, 0, 50, 0, 0), vector<int>({1, 0}));
+    }
+    tracks.update(detections, order, 0, idMax);
+    tracks.clean(order, 0);
+  }
+  EXPECT_EQ(tracks.vx, vector<double>({10, -10}));
+  EXPECT_EQ(tracks.vy, vector<double>({0, 0}));
+  EXPECT_LT(tracks.error[0], 0.1);
+
+  // The gate of a regular object shrinks to the minimal radius
+  detections.load({{Point3d(135, 0, 0), Point3d(-100, 6, 0)}});
+  EXPECT_EQ(tracking.costFunc(tracks, detections, 1, 0, 50, 0, 0), vector<int>({-1, 1}));
+  EXPECT_EQ(fixed.costFunc(tracks, detections, 1, 0, 50, 0, 0), vector<int>({0, 1}));
+}
+
+TEST_F(TrackingTest, costRowTerms) {
+  // Rows whose length is not a multiple of the vector width, the last objects are computed by the scalar loop
+  RNG rng(23);
+  array<double, 4> normalizations = {3, 0.5, 40, 12};
+  for (int count : {0, 1, 7, 13}) {
+    vector<double> x(count), y(count), angle(count), area(count), perimeter(count);
+    for (int j = 0; j < count; j++) {
+      x[j] = rng.uniform(-100., 100.);
+      y[j] = rng.uniform(-100., 100.);
+      angle[j] = rng.uniform(0., 2 * M_PI);
+      area[j] = rng.uniform(10., 500.);
+      perimeter[j] = rng.uniform(10., 200.);
+    }
+    array<double, 5> previous = {rng.uniform(-100., 100.), rng.uniform(-100., 100.), rng.uniform(0., 2 * M_PI), rng.uniform(10., 500.), rng.uniform(10., 200.)};
+
+    for (int terms = 0; terms < 16; terms++) {
+      array<double, 4> used, weights;
+      for (int k = 0; k < 4; k++) {
+        used[k] = (terms & (1 << k)) ? normalizations[k] : 0;
+      }
+      ASSERT_EQ(costTerms(used, weights), terms);
+      vector<double> distance(count), cost(count);
+      costRows[terms](previous, weights, x.data(), y.data(), angle.data(), area.data(), perimeter.data(), count, distance.data(), cost.data());
+
+      // Scalar cost formula
+      for (int j = 0; j < count; j++) {
+        double d = sqrt(pow(previous[0] - x[j], 2) + pow(previous[1] - y[j], 2));
+        double expected = 0;
+        expected += (terms & CostDistance) ? d / normalizations[0] : 0;
+        expected += (terms & CostAngle) ? abs(Tracking::angleDifference(previous[2], angle[j])) / normalizations[1] : 0;
+        expected += (terms & CostArea) ? abs(previous[3] - area[j]) / normalizations[2] : 0;
+        expected += (terms & CostPerimeter) ? abs(previous[4] - perimeter[j]) / normalizations[3] : 0;
+        EXPECT_NEAR(distance[j], d, 1e-12 * std::max(1., d));
+        EXPECT_NEAR(cost[j], expected, 1e-12 * std::max(1., expected));
+      }
+    }
+  }
+}
+
+TEST_F(TrackingTest, costFunctionGate) {
+  for (int solver = 0; solver < 3; solver++) {
+    Tracking tracking("", "");
+    QMap<QString, QString> params{{"spot", "0"}, {"solver", QString::number(solver)}};
+    tracking.updatingParameters(params);
+
+    // One previous object, only the second current object is closer than LO
+    TrackStore tracks, detections;
+    tracks.load({{Point3d(0, 0, 0)}});
+    detections.load({{Point3d(50, 0, 0), Point3d(3, 0, 0)}});
+    EXPECT_EQ(tracking.costFunc(tracks, detections, 1, 0, 10, 0, 0), vector<int>({1}));
+
+    // The optimal assignment of the full cost matrix pairs the second previous object with the second current object,
+    // farther than LO, the pair is rejected
+    tracks.load({{Point3d(0, 0, 0), Point3d(100, 0, 0)}});
+    detections.load({{Point3d(2, 0, 0), Point3d(200, 0, 0)}});
+    EXPECT_EQ(tracking.costFunc(tracks, detections, 1, 0, 10, 0, 0), vector<int>({0, -1}));
+
+    // Every current object is farther than LO
+    tracks.load({{Point3d(0, 0, 0)}});
+    detections.load({{Point3d(50, 0, 0), Point3d(0, 30, 0)}});
+    EXPECT_EQ(tracking.costFunc(tracks, detections, 1, 0, 10, 0, 0), vector<int>({-1}));
+  }
+}
+
+TEST_F(TrackingTest, costFunctionNonFinite) {
+  Tracking tracking("", ""), fixed("", "");
+  QMap<QString, QString> params{{"spot", "0"}, {"motionGate", "2"}};
+  tracking.updatingParameters(params);
+  params["motionGate"] = "0";
+  fixed.updatingParameters(params);
+
+  // A detection with a NaN head is never a candidate and does not change the grid of the other detections
+  TrackStore tracks, detections;
+  tracks.load({{Point3d(0, 0, 0), Point3d(100, 0, 0)}});
+  detections.load({{Point3d(NAN, NAN, 0), Point3d(1, 0, 0), Point3d(101, 0, 0)}});
+  EXPECT_EQ(fixed.costFunc(tracks, detections, 1, 0, 5, 0, 0), vector<int>({1, 2}));
+  EXPECT_EQ(tracking.costFunc(tracks, detections, 1, 0, 5, 0, 0), vector<int>({1, 2}));
+
+  // A prediction far outside the grid has no candidate
+  tracks.vx[1] = 1e300;
+  EXPECT_EQ(tracking.costFunc(tracks, detections, 1, 0, 5, 0, 0), vector<int>({1, -1}));
+
+  // A velocity that gives a non-finite prediction is not used, the gate is centred on the previous position
+  tracks.vx[1] = -INFINITY;
+  EXPECT_EQ(tracking.costFunc(tracks, detections, 1, 0, 5, 0, 0), vector<int>({1, 2}));
+  tracks.vx[1] = NAN;
+  EXPECT_EQ(tracking.costFunc(tracks, detections, 1, 0, 5, 0, 0), vector<int>({1, 2}));
+
+  // An object lost for a long time with a fast velocity is predicted far from every detection
+  tracks.vx[1] = 50;
+  tracks.lost[1] = 1000000;
+  EXPECT_EQ(tracking.costFunc(tracks, detections, 1, 0, 5, 0, 0), vector<int>({1, -1}));
+
+  // Only non-finite detections
+  detections.load({{Point3d(NAN, 0, 0), Point3d(INFINITY, 0, 0)}});
+  EXPECT_EQ(fixed.costFunc(tracks, detections, 1, 0, 5, 0, 0), vector<int>({-1, -1}));
+}
+
+TEST_F(TrackingTest, objectPositionStore) {
+  Tracking tracking("", "");
+
+  Mat frame = Mat::zeros(200, 200, CV_8U);
+  fillConvexPoly(frame, vector<Point>({Point(50, 55), Point(50, 95), Point(130, 75)}), Scalar(255));
+  circle(frame, Point(150, 150), 15, Scalar(255), FILLED);
+  circle(frame, Point(30, 170), 10, Scalar(255), FILLED);
+
+  // The objects are written directly in the store, with the same features as the vectors
+  for (int detector : {0, 1}) {
+    TrackStore store, reference;
+    reference.load(tracking.objectPosition(frame, 10, 10000, detector));
+    tracking.objectPosition(frame, 10, 10000, detector, Tracking::FeatureAll, store);
+    ASSERT_EQ(store.size(), size_t(3));
+    EXPECT_EQ(store.fields, reference.fields);
+    EXPECT_EQ(store.id, vector<int>({0, 1, 2}));
+    EXPECT_EQ(store.lost, vector<int>(3, 0));
+  }
+}
+
+TEST_F(TrackingTest, AssignmentSolvers) {
+  RNG rng(11);
+  Assignment solver;
+  HungarianAlgorithm reused;
+  for (auto [n, m] : vector<pair<int, int>>{{6, 6}, {4, 9}, {9, 4}, {1, 5}, {30, 25}}) {
+    // Dense problems, same optimal cost as the Hungarian algorithm
+    vector<vector<double>> matrix(n, vector<double>(m));
+    vector<double> flat;
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < m; j++) {
+        matrix[i][j] = rng.uniform(0., 10.);
+        flat.push_back(matrix[i][j]);
+      }
+    }
+    vector<int> reference, assignment;
+    HungarianAlgorithm hungarian;
+    double cost = hungarian.Solve(matrix, reference);
+    EXPECT_EQ(reused.Solve(flat.data(), n, m, assignment), cost);
+    EXPECT_EQ(assignment, reference);
+    EXPECT_NEAR(solver.solveDense(flat, n, m, assignment), cost, 1e-9);
+    EXPECT_EQ(int(count(assignment.begin(), assignment.end(), -1)), max(n - m, 0));
+
+    // Sparse problems, as many pairs and the same cost as the dense problem with a prohibitive cost
+    vector<int> rowStart = {0}, columns;
+    vector<double> costs;
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < m; j++) {
+        if (rng.uniform(0., 1.) < 0.3) {
+          columns.push_back(j);
+          costs.push_back(flat[i * m + j]);
+        }
+        else {
+          flat[i * m + j] = 1e4;
+        }
+      }
+      rowStart.push_back(int(columns.size()));
+    }
+    solver.solveDense(flat, n, m, reference);
+    double referenceCost = 0;
+    int referenceCount = 0;
+    for (int i = 0; i < n; i++) {
+      if (reference[i] != -1 && flat[i * m + reference[i]] < 1e4) {
+        referenceCost += flat[i * m + reference[i]];
+        referenceCount++;
+      }
+    }
+    EXPECT_NEAR(solver.solveSparse(n, m, rowStart, columns, costs, assignment), referenceCost, 1e-9);
+    EXPECT_EQ(n - int(count(assignment.begin(), assignment.end(), -1)), referenceCount);
+    for (int i = 0; i < n; i++) {
+      if (assignment[i] != -1) {
+        EXPECT_TRUE(find(columns.begin() + rowStart[i], columns.begin() + rowStart[i + 1], assignment[i]) != columns.begin() + rowStart[i + 1]);
+      }
+    }
+  }
+}
+
+TEST_F(TrackingTest, AssignmentEmpty) {
+  HungarianAlgorithm hungarian;
+  vector<vector<double>> matrix;
+  vector<int> assignment = {0, 1};
+  EXPECT_EQ(hungarian.Solve(matrix, assignment), 0);
+  EXPECT_TRUE(assignment.empty());
+  EXPECT_EQ(hungarian.Solve(nullptr, 2, 0, assignment), 0);
+  EXPECT_EQ(assignment, vector<int>({-1, -1}));
+}
+
+// Run with --gtest_also_run_disabled_tests to compare the speed of the assignment solvers
+TEST_F(TrackingTest, DISABLED_AssignmentBenchmark) {
+  Tracking tracking("", "");
+  RNG rng(13);
+  int n = 1000;
+  vector<vector<Point3d>> past(4, vector<Point3d>(n)), current(4, vector<Point3d>(n));
+  for (int i = 0; i < n; i++) {
+    past[0][i] = Point3d(rng.uniform(0., 2000.), rng.uniform(0., 2000.), rng.uniform(0., 2 * M_PI));
+    current[0][i] = past[0][i] + Point3d(rng.uniform(-10., 10.), rng.uniform(-10., 10.), 0);
+  }
+  vector<int> reference;
+  for (int solver : {0, 1, 2}) {
+    QMap<QString, QString> params{{"spot", "0"}, {"solver", QString::number(solver)}};
+    tracking.updatingParameters(params);
+    QElapsedTimer timer;
+    timer.start();
+    vector<int> order = tracking.costFunc(past, current, 10, M_PI, 30, 0, 0);
+    cout << "Solver " << solver << ": " << timer.elapsed() << " ms" << endl;
+    if (solver == 1) {
+      reference = order;
+    }
+    else if (solver == 2) {
+      EXPECT_EQ(order, reference);
+    }
+  }
+}
+
 // AutoSet test
 TEST_F(AutoLevelTest, AutoLevel) {
   UMat background;
@@ -74,9 +74,13 @@ SOURCES += \
         tracking.cpp \
         videoreader.cpp \
         Hungarian.cpp \
+        assignment.cpp \
+        trackstore.cpp \
 
 
 HEADERS += \
         tracking.h \
         videoreader.h \
         Hungarian.h \
+        assignment.h \
+        trackstore.h \
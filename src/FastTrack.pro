@@ -85,6 +85,8 @@ SOURCES += \
         mainwindow.cpp \
         tracking.cpp \
         Hungarian.cpp \
+        assignment.cpp \
+        trackstore.cpp \
         replay.cpp \
         batch.cpp \
         interactive.cpp \
@@ -100,6 +102,8 @@ HEADERS += \
         mainwindow.h\
         tracking.h \
         Hungarian.h \
+        assignment.h \
+        trackstore.h \
         replay.h \
         batch.h \
         interactive.h \
@@ -11,6 +11,7 @@
 
 #include "Hungarian.h"
 #include <stdlib.h>
+#include <algorithm>
 #include <cfloat>  // for DBL_MAX
 #include <cmath>   // for fabs()
 
@@ -21,33 +22,70 @@ HungarianAlgorithm::~HungarianAlgorithm() {}
 // A single function wrapper for solving assignment problem.
 //********************************************************//
 double HungarianAlgorithm::Solve(vector<vector<double> > &DistMatrix, vector<int> &Assignment) {
-  unsigned int nRows = static_cast<unsigned int>(DistMatrix.size());
-  unsigned int nCols = static_cast<unsigned int>(DistMatrix[0].size());
+  if (DistMatrix.empty()) {
+    Assignment.clear();
+    return 0.0;
+  }
 
-  double *distMatrixIn = new double[nRows * nCols];
-  int *assignment = new int[nRows];
+  int nRows = static_cast<int>(DistMatrix.size());
+  int nCols = static_cast<int>(DistMatrix[0].size());
   double cost = 0.0;
 
+  reserveWorkspace(nRows, nCols);
+
   // Fill in the distMatrixIn. Mind the index is "i + nRows * j".
   // Here the cost matrix of size MxN is defined as a double precision array of N*M elements.
   // In the solving functions matrices are seen to be saved MATLAB-internally in row-order.
   // (i.e. the matrix [1 2; 3 4] will be stored as a vector [1 3 2 4], NOT [1 2 3 4]).
-  for (unsigned int i = 0; i < nRows; i++)
-    for (unsigned int j = 0; j < nCols; j++)
-      distMatrixIn[i + nRows * j] = DistMatrix[i][j];
+  for (int i = 0; i < nRows; i++)
+    for (int j = 0; j < nCols; j++)
+      m_distMatrixIn[i + nRows * j] = DistMatrix[i][j];
 
   // call solving function
-  assignmentoptimal(assignment, &cost, distMatrixIn, nRows, nCols);
+  Assignment.resize(nRows);
+  assignmentoptimal(Assignment.data(), &cost, m_distMatrixIn.data(), nRows, nCols);
+
+  return cost;
+}
+
+//********************************************************//
+// Same as above for a cost matrix of nRows x nCols elements stored contiguously in row-major order.
+// The workspace is reused, no memory is allocated once a problem of this size has been solved.
+//********************************************************//
+double HungarianAlgorithm::Solve(const double *DistMatrix, int nRows, int nCols, vector<int> &Assignment) {
+  double cost = 0.0;
+  Assignment.resize(nRows);
+  if (nRows == 0 || nCols == 0) {
+    std::fill(Assignment.begin(), Assignment.end(), -1);
+    return cost;
+  }
+
+  reserveWorkspace(nRows, nCols);
+  for (int i = 0; i < nRows; i++)
+    for (int j = 0; j < nCols; j++)
+      m_distMatrixIn[i + nRows * j] = DistMatrix[i * nCols + j];
 
-  Assignment.clear();
-  for (unsigned int r = 0; r < nRows; r++)
-    Assignment.push_back(assignment[r]);
+  assignmentoptimal(Assignment.data(), &cost, m_distMatrixIn.data(), nRows, nCols);
 
-  delete[] distMatrixIn;
-  delete[] assignment;
   return cost;
 }
 
+//********************************************************//
+// Grows the workspace to hold a problem of nOfRows x nOfColumns elements, it never shrinks.
+//********************************************************//
+void HungarianAlgorithm::reserveWorkspace(int nOfRows, int nOfColumns) {
+  size_t nOfElements = size_t(nOfRows) * size_t(nOfColumns);
+  if (m_distMatrixIn.size() < nOfElements) {
+    m_distMatrixIn.resize(nOfElements);
+    m_distMatrixWork.resize(nOfElements);
+  }
+  size_t nOfFlags = size_t(nOfRows) + size_t(nOfColumns) + 3 * nOfElements;
+  if (m_flagsCapacity < nOfFlags) {
+    m_flags.reset(new bool[nOfFlags]);
+    m_flagsCapacity = nOfFlags;
+  }
+}
+
 //********************************************************//
 // Solve optimal solution for assignment problem using Munkres algorithm, also known as Hungarian Algorithm.
 //********************************************************//
@@ -64,7 +102,7 @@ void HungarianAlgorithm::assignmentoptimal(int *assignment, double *cost, double
   /* generate working copy of distance Matrix */
   /* check if all matrix elements are positive */
   nOfElements = nOfRows * nOfColumns;
-  distMatrix = (double *)malloc(nOfElements * sizeof(double));
+  distMatrix = m_distMatrixWork.data();
   distMatrixEnd = distMatrix + nOfElements;
 
   for (row = 0; row < nOfElements; row++) {
@@ -74,12 +112,13 @@ void HungarianAlgorithm::assignmentoptimal(int *assignment, double *cost, double
     distMatrix[row] = value;
   }
 
-  /* memory allocation */
-  coveredColumns = (bool *)calloc(nOfColumns, sizeof(bool));
-  coveredRows = (bool *)calloc(nOfRows, sizeof(bool));
-  starMatrix = (bool *)calloc(nOfElements, sizeof(bool));
-  primeMatrix = (bool *)calloc(nOfElements, sizeof(bool));
-  newStarMatrix = (bool *)calloc(nOfElements, sizeof(bool)); /* used in step4 */
+  /* workspace partition, cleared as by calloc */
+  coveredColumns = m_flags.get();
+  coveredRows = coveredColumns + nOfColumns;
+  starMatrix = coveredRows + nOfRows;
+  primeMatrix = starMatrix + nOfElements;
+  newStarMatrix = primeMatrix + nOfElements; /* used in step4 */
+  std::fill(coveredColumns, newStarMatrix + nOfElements, false);
 
   /* preliminary steps */
   if (nOfRows <= nOfColumns) {
@@ -157,14 +196,6 @@ void HungarianAlgorithm::assignmentoptimal(int *assignment, double *cost, double
   /* compute cost and remove invalid assignments */
   computeassignmentcost(assignment, cost, distMatrixIn, nOfRows);
 
-  /* free allocated memory */
-  free(distMatrix);
-  free(coveredColumns);
-  free(coveredRows);
-  free(starMatrix);
-  free(primeMatrix);
-  free(newStarMatrix);
-
   return;
 }
 
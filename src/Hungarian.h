@@ -13,6 +13,7 @@
 #define HUNGARIAN_H
 
 #include <iostream>
+#include <memory>
 #include <vector>
 
 using namespace std;
@@ -21,9 +22,19 @@ class HungarianAlgorithm {
  public:
   HungarianAlgorithm();
   ~HungarianAlgorithm();
+  HungarianAlgorithm(HungarianAlgorithm &&) = default;
+  HungarianAlgorithm &operator=(HungarianAlgorithm &&) = default;
   double Solve(vector<vector<double> > &DistMatrix, vector<int> &Assignment);
+  double Solve(const double *DistMatrix, int nRows, int nCols, vector<int> &Assignment);
 
  private:
+  // Workspace kept between the calls, sized to the largest problem solved so far
+  vector<double> m_distMatrixIn;     // cost matrix in column major order
+  vector<double> m_distMatrixWork;   // working copy of the cost matrix
+  unique_ptr<bool[]> m_flags;        // covered columns, covered rows, star, prime and new star matrices
+  size_t m_flagsCapacity = 0;
+
+  void reserveWorkspace(int nOfRows, int nOfColumns);
   void assignmentoptimal(int *assignment, double *cost, double *distMatrix, int nOfRows, int nOfColumns);
   void buildassignmentvector(int *assignment, bool *starMatrix, int nOfRows, int nOfColumns);
   void computeassignmentcost(int *assignment, double *cost, double *distMatrix, int nOfRows);
@@ -0,0 +1,237 @@
+/*
+This file is part of Fast Track.
+
+    FastTrack is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastTrack is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastTrack.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "assignment.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+/**
+ * @class Assignment
+ *
+ * @brief Solves the linear assignment problem by shortest augmenting paths, as in the Jonker-Volgenant algorithm. Each row is assigned in turn by the shortest path to a free column in the reduced costs, the dual variables keep the reduced costs non-negative. The buffers are kept between the calls.
+ */
+
+/**
+ * @brief Solves a dense assignment problem in O(n²m), every row is assigned if there are more columns than rows and every column otherwise.
+ * @param[in] cost Cost matrix in row major order, the costs have to be finite.
+ * @param[in] rowCount Number of rows.
+ * @param[in] columnCount Number of columns.
+ * @param[out] assignment Column assigned to each row, -1 if the row is not assigned.
+ * @return The total cost of the assignment.
+ */
+double Assignment::solveDense(const vector<double> &cost, int rowCount, int columnCount, vector<int> &assignment) {
+  assignment.assign(rowCount, -1);
+  if (rowCount == 0 || columnCount == 0) {
+    return 0;
+  }
+
+  // The algorithm assigns every row, the matrix is transposed if there are more rows than columns
+  bool isTransposed = rowCount > columnCount;
+  const double *a = cost.data();
+  int n = rowCount, m = columnCount;
+  if (isTransposed) {
+    m_cost.resize(cost.size());
+    for (int i = 0; i < rowCount; i++) {
+      for (int j = 0; j < columnCount; j++) {
+        m_cost[size_t(j) * size_t(rowCount) + size_t(i)] = cost[size_t(i) * size_t(columnCount) + size_t(j)];
+      }
+    }
+    a = m_cost.data();
+    std::swap(n, m);
+  }
+
+  // The column m is a virtual column holding the row being assigned
+  const double infinity = std::numeric_limits<double>::infinity();
+  m_rowPotential.assign(n, 0);
+  m_columnPotential.assign(m + 1, 0);
+  m_columnRow.assign(m + 1, -1);
+  m_predecessor.assign(m + 1, m);
+  for (int i = 0; i < n; i++) {
+    m_columnRow[m] = i;
+    int column = m;
+    m_distance.assign(m + 1, infinity);
+    m_isScanned.assign(m + 1, false);
+
+    // Dijkstra search of the shortest augmenting path in the reduced costs
+    do {
+      m_isScanned[column] = true;
+      int row = m_columnRow[column];
+      const double *rowCost = a + size_t(row) * size_t(m);
+      double delta = infinity;
+      int next = -1;
+      for (int j = 0; j < m; j++) {
+        if (!m_isScanned[j]) {
+          double reduced = rowCost[j] - m_rowPotential[row] - m_columnPotential[j];
+          if (reduced < m_distance[j]) {
+            m_distance[j] = reduced;
+            m_predecessor[j] = column;
+          }
+          if (m_distance[j] < delta) {
+            delta = m_distance[j];
+            next = j;
+          }
+        }
+      }
+      for (int j = 0; j <= m; j++) {
+        if (m_isScanned[j]) {
+          m_rowPotential[m_columnRow[j]] += delta;
+          m_columnPotential[j] -= delta;
+        }
+        else {
+          m_distance[j] -= delta;
+        }
+      }
+      column = next;
+    } while (m_columnRow[column] != -1);
+
+    // Augments along the path
+    do {
+      int previous = m_predecessor[column];
+      m_columnRow[column] = m_columnRow[previous];
+      column = previous;
+    } while (column != m);
+  }
+
+  double total = 0;
+  for (int j = 0; j < m; j++) {
+    int i = m_columnRow[j];
+    if (i != -1) {
+      (isTransposed) ? (assignment[j] = i) : (assignment[i] = j);
+      total += a[size_t(i) * size_t(m) + size_t(j)];
+    }
+  }
+  return total;
+}
+
+/**
+ * @brief Solves a sparse assignment problem where each row can only be assigned to its candidate columns. The number of assigned rows is maximal, and the total cost minimal among the assignments with this number of rows. Each row has a private unassigned column with a cost above any difference of total cost, the search only visits the candidates.
+ * @param[in] rowCount Number of rows.
+ * @param[in] columnCount Number of columns.
+ * @param[in] rowStart Index of the first candidate of each row in columns and costs, of size rowCount + 1.
+ * @param[in] columns Candidate columns of all the rows.
+ * @param[in] costs Non-negative costs of the candidates.
+ * @param[out] assignment Column assigned to each row, -1 if the row is not assigned.
+ * @return The total cost of the assignment.
+ */
+double Assignment::solveSparse(int rowCount, int columnCount, const vector<int> &rowStart, const vector<int> &columns, const vector<double> &costs, vector<int> &assignment) {
+  assignment.assign(rowCount, -1);
+  if (rowCount == 0 || columnCount == 0) {
+    return 0;
+  }
+
+  // An unassigned row costs more than assigning the rows with the largest costs
+  double maxCost = 0;
+  for (double a : costs) {
+    maxCost = std::max(maxCost, a);
+  }
+  double unassignedCost = maxCost * (std::min(rowCount, columnCount) + 1) + 1;
+
+  // The columns columnCount + i are the unassigned columns of the rows i
+  int m = columnCount + rowCount;
+  m_columnPotential.assign(m, 0);
+  m_columnRow.assign(m, -1);
+  m_rowColumn.assign(rowCount, -1);
+  m_matchedCost.assign(rowCount, 0);
+  m_distance.resize(m);
+  m_predecessor.resize(m);
+  m_predecessorCost.resize(m);
+  m_isReached.assign(m, false);
+  m_isScanned.assign(m, false);
+
+  for (int s = 0; s < rowCount; s++) {
+    m_visited.clear();
+    m_scanned.clear();
+    m_heap.clear();
+
+    // The distance of a column is its reduced cost from the row s, the reduced cost of an assigned row is 0
+    auto relax = [&](int row, double offset, int column, double cost) {
+      double distance = offset + cost - m_columnPotential[column];
+      if (!m_isReached[column] || distance < m_distance[column]) {
+        if (!m_isReached[column]) {
+          m_isReached[column] = true;
+          m_visited.push_back(column);
+        }
+        m_distance[column] = distance;
+        m_predecessor[column] = row;
+        m_predecessorCost[column] = cost;
+        m_heap.push_back({distance, column});
+        std::push_heap(m_heap.begin(), m_heap.end(), std::greater<pair<double, int>>());
+      }
+    };
+    auto relaxRow = [&](int row, double offset) {
+      for (int k = rowStart[row]; k < rowStart[row + 1]; k++) {
+        if (!m_isScanned[columns[k]]) {
+          relax(row, offset, columns[k], costs[k]);
+        }
+      }
+      if (!m_isScanned[columnCount + row]) {
+        relax(row, offset, columnCount + row, unassignedCost);
+      }
+    };
+
+    relaxRow(s, 0);
+    int sink = -1;
+    double delta = 0;
+    while (!m_heap.empty()) {
+      std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<pair<double, int>>());
+      auto [distance, column] = m_heap.back();
+      m_heap.pop_back();
+      if (m_isScanned[column] || distance > m_distance[column]) {
+        continue;
+      }
+      m_isScanned[column] = true;
+      m_scanned.push_back(column);
+      int row = m_columnRow[column];
+      if (row == -1) {
+        sink = column;
+        delta = distance;
+        break;
+      }
+      relaxRow(row, distance - (m_matchedCost[row] - m_columnPotential[column]));
+    }
+
+    // Updates the dual variables of the finalized columns, the reduced costs stay non-negative
+    for (int j : m_scanned) {
+      m_columnPotential[j] += m_distance[j] - delta;
+    }
+
+    // Augments along the path, the row s always reaches its unassigned column
+    for (int column = sink; column != -1;) {
+      int row = m_predecessor[column];
+      int previous = m_rowColumn[row];
+      m_columnRow[column] = row;
+      m_rowColumn[row] = column;
+      m_matchedCost[row] = m_predecessorCost[column];
+      column = previous;
+    }
+
+    for (int j : m_visited) {
+      m_isReached[j] = false;
+      m_isScanned[j] = false;
+    }
+  }
+
+  double total = 0;
+  for (int i = 0; i < rowCount; i++) {
+    if (m_rowColumn[i] < columnCount) {
+      assignment[i] = m_rowColumn[i];
+      total += m_matchedCost[i];
+    }
+  }
+  return total;
+}
@@ -0,0 +1,48 @@
+/*
+This file is part of Fast Track.
+
+    FastTrack is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastTrack is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastTrack.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ASSIGNMENT_H
+#define ASSIGNMENT_H
+
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+class Assignment {
+  vector<double> m_cost;              /*!< Transposed cost matrix when there are more rows than columns. */
+  vector<double> m_rowPotential;      /*!< Dual variable of each row. */
+  vector<double> m_columnPotential;   /*!< Dual variable of each column. */
+  vector<double> m_distance;          /*!< Shortest path distance to each column. */
+  vector<double> m_matchedCost;       /*!< Cost of the column assigned to each row. */
+  vector<double> m_predecessorCost;   /*!< Cost of the edge from the predecessor row to each column. */
+  vector<int> m_columnRow;            /*!< Row assigned to each column, -1 if the column is free. */
+  vector<int> m_rowColumn;            /*!< Column assigned to each row, -1 if the row is free. */
+  vector<int> m_predecessor;          /*!< Predecessor of each column in the shortest path. */
+  vector<int> m_visited;              /*!< Columns reached by the current shortest path search. */
+  vector<int> m_scanned;              /*!< Columns finalized by the current shortest path search, in their order. */
+  vector<char> m_isReached;           /*!< True for the columns reached by the current shortest path search. */
+  vector<char> m_isScanned;           /*!< True for the columns finalized by the current shortest path search. */
+  vector<pair<double, int>> m_heap;   /*!< Priority queue of the shortest path search. */
+
+ public:
+  Assignment() = default;
+  double solveDense(const vector<double> &cost, int rowCount, int columnCount, vector<int> &assignment);
+  double solveSparse(int rowCount, int columnCount, const vector<int> &rowStart, const vector<int> &columns, const vector<double> &costs, vector<int> &assignment);
+};
+
+#endif
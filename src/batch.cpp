@@ -58,7 +58,7 @@ Batch::Batch(QWidget *parent) : QWidget(parent),
   qRegisterMetaType<UMat>("UMat&");
   qRegisterMetaType<QMap<QString, QString>>("QMap<QString, QString>");
 
-  // Unactivates OpenCl that can slow-down the program
+  // Unactivates OpenCl that can slow-down the program, each analysis selects its own backend with the backend parameter
   cv::ocl::setUseOpenCL(false);
 
   ui->tableParameters->horizontalHeader()->setStretchLastSection(true);
@@ -225,6 +225,71 @@ Batch::Batch(QWidget *parent) : QWidget(parent),
   ui->tableParameters->setCellWidget(21, 1, perim);
   connect(perim, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &Batch::updateParameters);
 
+  ui->tableParameters->insertRow(22);
+  ui->tableParameters->setItem(22, 0, new QTableWidgetItem("adaptiveThresh"));
+  QSpinBox *adaptiveThresh = new QSpinBox(ui->tableParameters);
+  adaptiveThresh->setRange(0, 2047);
+  ui->tableParameters->setCellWidget(22, 1, adaptiveThresh);
+  connect(adaptiveThresh, QOverload<int>::of(&QSpinBox::valueChanged), this, &Batch::updateParameters);
+
+  ui->tableParameters->insertRow(23);
+  ui->tableParameters->setItem(23, 0, new QTableWidgetItem("backend"));
+  QComboBox *backend = new QComboBox(ui->tableParameters);
+  backend->addItems({"CPU multi-threaded", "CPU single-threaded", "OpenCL"});
+  ui->tableParameters->setCellWidget(23, 1, backend);
+  connect(backend, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &Batch::updateParameters);
+
+  ui->tableParameters->insertRow(24);
+  ui->tableParameters->setItem(24, 0, new QTableWidgetItem("detector"));
+  QComboBox *detector = new QComboBox(ui->tableParameters);
+  detector->addItems({"Contours", "Connected components", "Connected components (tiled)"});
+  ui->tableParameters->setCellWidget(24, 1, detector);
+  connect(detector, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &Batch::updateParameters);
+
+  ui->tableParameters->insertRow(25);
+  ui->tableParameters->setItem(25, 0, new QTableWidgetItem("features"));
+  QLineEdit *features = new QLineEdit(ui->tableParameters);
+  features->setPlaceholderText("head,tail,body,curvature,area,perimeter");
+  ui->tableParameters->setCellWidget(25, 1, features);
+  connect(features, &QLineEdit::editingFinished, this, &Batch::updateParameters);
+
+  ui->tableParameters->insertRow(26);
+  ui->tableParameters->setItem(26, 0, new QTableWidgetItem("coarseScale"));
+  QSpinBox *coarseScale = new QSpinBox(ui->tableParameters);
+  coarseScale->setRange(0, 64);
+  ui->tableParameters->setCellWidget(26, 1, coarseScale);
+  connect(coarseScale, QOverload<int>::of(&QSpinBox::valueChanged), this, &Batch::updateParameters);
+
+  ui->tableParameters->insertRow(27);
+  ui->tableParameters->setItem(27, 0, new QTableWidgetItem("nObject"));
+  QSpinBox *nObject = new QSpinBox(ui->tableParameters);
+  nObject->setRange(0, 100000);
+  ui->tableParameters->setCellWidget(27, 1, nObject);
+  connect(nObject, QOverload<int>::of(&QSpinBox::valueChanged), this, &Batch::updateParameters);
+
+  ui->tableParameters->insertRow(28);
+  ui->tableParameters->setItem(28, 0, new QTableWidgetItem("changeTile"));
+  QSpinBox *changeTile = new QSpinBox(ui->tableParameters);
+  changeTile->setRange(0, 256);
+  ui->tableParameters->setCellWidget(28, 1, changeTile);
+  connect(changeTile, QOverload<int>::of(&QSpinBox::valueChanged), this, &Batch::updateParameters);
+
+  ui->tableParameters->insertRow(29);
+  ui->tableParameters->setItem(29, 0, new QTableWidgetItem("solver"));
+  QComboBox *solver = new QComboBox(ui->tableParameters);
+  solver->addItems({"Hungarian", "Shortest augmenting path", "Shortest augmenting path (sparse)"});
+  ui->tableParameters->setCellWidget(29, 1, solver);
+  connect(solver, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &Batch::updateParameters);
+
+  ui->tableParameters->insertRow(30);
+  ui->tableParameters->setItem(30, 0, new QTableWidgetItem("motionGate"));
+  QDoubleSpinBox *motionGate = new QDoubleSpinBox(ui->tableParameters);
+  motionGate->setRange(0, 9999999);
+  motionGate->setValue(0.0);
+  motionGate->setSingleStep(0.1);
+  ui->tableParameters->setCellWidget(30, 1, motionGate);
+  connect(motionGate, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &Batch::updateParameters);
+
   loadSettings();
 
   // Setups the path panel
@@ -483,9 +548,10 @@ void Batch::startTracking() {
 void Batch::updateParameters() {
   if (isEditable) {
     // Updates SpinBox parameters
-    QList<int> spinBoxIndexes = {1, 2, 4, 5, 6, 7, 11, 12, 13, 16, 17};
-    QList<int> doubleSpinBoxIndexes = {14, 15, 20, 21};
-    QList<int> comboBoxIndexes = {3, 8, 9, 10, 18, 19};
+    QList<int> spinBoxIndexes = {1, 2, 4, 5, 6, 7, 11, 12, 13, 16, 17, 22, 26, 27, 28};
+    QList<int> doubleSpinBoxIndexes = {14, 15, 20, 21, 30};
+    QList<int> comboBoxIndexes = {3, 8, 9, 10, 18, 19, 23, 24, 29};
+    QList<int> lineEditIndexes = {25};
 
     for (auto &a : spinBoxIndexes) {
       parameterList.insert(ui->tableParameters->item(a, 0)->text(), QString::number(qobject_cast<QSpinBox *>(ui->tableParameters->cellWidget(a, 1))->value()));
@@ -496,6 +562,9 @@ void Batch::updateParameters() {
     for (auto &a : comboBoxIndexes) {
       parameterList.insert(ui->tableParameters->item(a, 0)->text(), QString::number(qobject_cast<QComboBox *>(ui->tableParameters->cellWidget(a, 1))->currentIndex()));
     }
+    for (auto &a : lineEditIndexes) {
+      parameterList.insert(ui->tableParameters->item(a, 0)->text(), qobject_cast<QLineEdit *>(ui->tableParameters->cellWidget(a, 1))->text());
+    }
 
     saveSettings();
     emit(newParameterList(parameterList));
@@ -580,6 +649,9 @@ void Batch::updateParameterTable() {
     else if (qobject_cast<QComboBox *>(ui->tableParameters->cellWidget(i, 1))) {
       qobject_cast<QComboBox *>(ui->tableParameters->cellWidget(i, 1))->setCurrentIndex(parameterList.value(label).toInt());
     }
+    else if (qobject_cast<QLineEdit *>(ui->tableParameters->cellWidget(i, 1))) {
+      qobject_cast<QLineEdit *>(ui->tableParameters->cellWidget(i, 1))->setText(parameterList.value(label));
+    }
   }
   isEditable = true;
 }
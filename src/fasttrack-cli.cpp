@@ -68,6 +68,7 @@ All arguments are mandatory except --backPath and --cfg. Loading a configuration
 \n\
   --lightBack                is the background light? 0: Yes, 1: No\n\
   --thresh                   binary threshold, if lightBack is set to 0 (resp. 1), pixels with values less (resp. more) than thresh are considered to belong to an object\n\
+  --adaptiveThresh           optional, radius in pixels of the neighborhood used for an adaptive threshold, pixels are then considered to belong to an object if they differ from the local mean by more than thresh, 0: global threshold\n\
    --reg                     registration method, 0: None, 1: Simple, 2: ECC, 3: Features\n\
 \n\
   --spot                     part of the object that features is used for the matching, 0: head, 1: tail, 2: body\n\
@@ -90,6 +91,15 @@ All arguments are mandatory except --backPath and --cfg. Loading a configuration
   --morph                    morphological operation, 0: None, 1: Erode, 2: Dilate, 3: Open, 4: Close, 5: Gradient, 6: TopHat, 7: BlackHat, 8: HitMiss\n\
   --morphSize                size of the kernel used in the morphological operation, can be omited if no operation are performed\n\
   --morphType                type of the kernel used in the morphological operation, can be omited if no operation are performed, 0: Rect, 1: Cross, 2: Ellipse\n\
+\n\
+  --backend                  optional, compute backend, 0: multi-threaded CPU, 1: single-threaded CPU, 2: OpenCL\n\
+  --detector                 optional, objects detector, 0: contours, 1: connected components (faster for many small objects, the area is the number of pixels), 2: tiled connected components (same as 1, faster for very large images)\n\
+  --features                 optional, features extracted for each object separated by commas, head, tail, body, curvature, area, perimeter, empty for all, the area and the perimeter are always extracted if normArea and normPerim are not 0\n\
+  --coarseScale              optional, block size of the coarse detection, only the windows around the objects found on the image reduced by this factor are processed, the whole image is processed if the windows cover more than a quarter of the image, 0: whole image\n\
+  --nObject                  optional, number of objects, while all the objects are tracked only the windows around their previous positions are processed, 0: unknown\n\
+  --changeTile               optional, tile size of the change driven processing, only the tiles that changed since the previous image are processed again, 0: whole image\n\
+  --solver                   optional, assignment solver, 0: Hungarian, 1: shortest augmenting path, 2: sparse shortest augmenting path (faster for many objects)\n\
+  --motionGate               optional, minimal radius in pixels of the gate centred on the position of each object predicted at constant velocity, the gate adapts to the prediction error up to maxDist, 0: gate of radius maxDist around the previous position\n\
 \n\
   --path                     path to the movie or one image of a sequence\n\
   --backPath                 optional, path to a background image\n\
@@ -112,6 +122,15 @@ int main(int argc, char **argv) {
           {"maxDist", required_argument, 0, 'g'},
           {"maxTime", required_argument, 0, 'h'},
           {"thresh", required_argument, 0, 'i'},
+          {"adaptiveThresh", required_argument, 0, 'B'},
+          {"backend", required_argument, 0, 'C'},
+          {"detector", required_argument, 0, 'D'},
+          {"features", required_argument, 0, 'E'},
+          {"coarseScale", required_argument, 0, 'F'},
+          {"nObject", required_argument, 0, 'G'},
+          {"changeTile", required_argument, 0, 'H'},
+          {"solver", required_argument, 0, 'I'},
+          {"motionGate", required_argument, 0, 'J'},
           {"nBack", required_argument, 0, 'j'},
           {"methBack", required_argument, 0, 'k'},
           {"regBack", required_argument, 0, 'l'},
@@ -135,7 +154,7 @@ int main(int argc, char **argv) {
   int c;
   QMap<QString, QString> parameters;
   while (1) {
-    c = getopt_long(argc, argv, "a:b:c:d:e:f:g:h:i:j:k:l:m:n:o:p:q:r:s:t:u:v:w:x:y:z:A", long_options, &option_index);
+    c = getopt_long(argc, argv, "a:b:c:d:e:f:g:h:i:j:k:l:m:n:o:p:q:r:s:t:u:v:w:x:y:z:AB:C:D:E:F:G:H:I:J:", long_options, &option_index);
 
     if (c == -1) {
       break;
@@ -228,6 +247,33 @@ int main(int argc, char **argv) {
       case 'z':
         parameters.insert("normPerim", QString::fromStdString(optarg));
         break;
+      case 'B':
+        parameters.insert("adaptiveThresh", QString::fromStdString(optarg));
+        break;
+      case 'C':
+        parameters.insert("backend", QString::fromStdString(optarg));
+        break;
+      case 'D':
+        parameters.insert("detector", QString::fromStdString(optarg));
+        break;
+      case 'E':
+        parameters.insert("features", QString::fromStdString(optarg));
+        break;
+      case 'F':
+        parameters.insert("coarseScale", QString::fromStdString(optarg));
+        break;
+      case 'G':
+        parameters.insert("nObject", QString::fromStdString(optarg));
+        break;
+      case 'H':
+        parameters.insert("changeTile", QString::fromStdString(optarg));
+        break;
+      case 'I':
+        parameters.insert("solver", QString::fromStdString(optarg));
+        break;
+      case 'J':
+        parameters.insert("motionGate", QString::fromStdString(optarg));
+        break;
     }
   }
 
@@ -434,6 +434,10 @@ Interactive::Interactive(QWidget *parent) : QMainWindow(parent),
     ui->isBin->setChecked(true);
     display(ui->slider->value());
   });
+  connect(ui->adaptiveThresh, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), [this]() {
+    ui->isBin->setChecked(true);
+    display(ui->slider->value());
+  });
   connect(ui->kernelType, static_cast<void (QComboBox::*)(int)>(&QComboBox::activated), [this]() {
     ui->isBin->setChecked(true);
     display(ui->slider->value());
@@ -629,7 +633,7 @@ void Interactive::display(int index, int scale) {
     // Computes the binary image an applies morphological operations
     else if (ui->isBin->isChecked() && isBackground) {
       (ui->backColor->currentText() == "Light background") ? (subtract(background, frame, frame)) : (subtract(frame, background, frame));
-      Tracking::binarisation(frame, 'b', ui->threshBox->value());
+      (ui->adaptiveThresh->value() > 0) ? Tracking::adaptiveBinarisation(frame, ui->adaptiveThresh->value(), ui->threshBox->value()) : Tracking::binarisation(frame, 'b', ui->threshBox->value());
       if (ui->morphOperation->currentIndex() != 8) {
         Mat element = getStructuringElement(ui->kernelType->currentIndex(), Size(2 * ui->kernelSize->value() + 1, 2 * ui->kernelSize->value() + 1), Point(ui->kernelSize->value(), ui->kernelSize->value()));
         morphologyEx(frame, frame, ui->morphOperation->currentIndex(), element);  // MorphTypes enum and QComboBox indexes have to match
@@ -870,6 +874,7 @@ void Interactive::getParameters() {
   parameters.insert("normPerim", QString::number(ui->normPerim->value()));
 
   parameters.insert("thresh", QString::number(ui->threshBox->value()));
+  parameters.insert("adaptiveThresh", QString::number(ui->adaptiveThresh->value()));
   parameters.insert("nBack", QString::number(ui->nBack->value()));
   parameters.insert("methBack", QString::number(ui->back->currentIndex()));
   parameters.insert("regBack", QString::number(ui->registrationBack->currentIndex()));
@@ -882,6 +887,14 @@ void Interactive::getParameters() {
   parameters.insert("morphSize", QString::number(ui->kernelSize->value()));
   parameters.insert("morphType", QString::number(ui->kernelType->currentIndex()));
   parameters.insert("lightBack", QString::number(ui->backColor->currentIndex()));
+  parameters.insert("backend", QString::number(ui->backend->currentIndex()));
+  parameters.insert("detector", QString::number(ui->detector->currentIndex()));
+  parameters.insert("features", ui->features->text());
+  parameters.insert("coarseScale", QString::number(ui->coarseScale->value()));
+  parameters.insert("nObject", QString::number(ui->nObject->value()));
+  parameters.insert("changeTile", QString::number(ui->changeTile->value()));
+  parameters.insert("solver", QString::number(ui->solver->currentIndex()));
+  parameters.insert("motionGate", QString::number(ui->motionGate->value()));
 }
 
 /**
@@ -1245,6 +1258,7 @@ void Interactive::loadParameters(QString path) {
     ui->normPerim->setValue(parameterList.value("normPerim").toDouble());
 
     ui->threshBox->setValue(parameterList.value("thresh").toInt());
+    ui->adaptiveThresh->setValue(parameterList.value("adaptiveThresh").toInt());
     ui->nBack->setValue(parameterList.value("nBack").toInt());
     ui->back->setCurrentIndex(parameterList.value("methBack").toInt());
     ui->registrationBack->setCurrentIndex(parameterList.value("regBack").toInt());
@@ -1257,6 +1271,14 @@ void Interactive::loadParameters(QString path) {
     ui->morphOperation->setCurrentIndex(parameterList.value("morph").toInt());
     ui->kernelSize->setValue(parameterList.value("morphSize").toInt());
     ui->kernelType->setCurrentIndex(parameterList.value("morphType").toInt());
+    ui->backend->setCurrentIndex(parameterList.value("backend").toInt());
+    ui->detector->setCurrentIndex(parameterList.value("detector").toInt());
+    ui->features->setText(parameterList.value("features"));
+    ui->coarseScale->setValue(parameterList.value("coarseScale").toInt());
+    ui->nObject->setValue(parameterList.value("nObject").toInt());
+    ui->changeTile->setValue(parameterList.value("changeTile").toInt());
+    ui->solver->setCurrentIndex(parameterList.value("solver").toInt());
+    ui->motionGate->setValue(parameterList.value("motionGate").toDouble());
   }
   parameterFile.close();
 }
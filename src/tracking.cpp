@@ -16,7 +16,9 @@ This file is part of Fast Track.
 */
 
 #include "tracking.h"
-#include "Hungarian.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace cv;
 using namespace std;
@@ -25,6 +27,562 @@ using namespace std;
 #define M_PI 3.14159265358979323846
 #endif
 
+namespace {
+
+/**
+ * @brief Thresholds an image in place, shared by the Mat and UMat overloads of Tracking::binarisation.
+ */
+template <typename T>
+void thresholdImage(T &frame, char backgroundColor, int value) {
+  frame.convertTo(frame, CV_8U);
+
+  if (backgroundColor == 'b') {
+    threshold(frame, frame, value, 255, THRESH_BINARY);
+  }
+
+  if (backgroundColor == 'w') {
+    threshold(frame, frame, value, 255, THRESH_BINARY_INV);
+  }
+}
+
+/**
+ * @brief Returns the number of stripes of a parallel_for_ loop. OpenCV runs a loop of one stripe in the calling thread, the serial loops do not change the number of threads of OpenCV shared by the whole process.
+ * @param[in] isParallel False to run the loop in the calling thread.
+ * @param[in] nstripes Number of stripes of the parallel loop, -1 to let OpenCV split the range.
+ */
+double loopStripes(bool isParallel, double nstripes = -1) {
+  return isParallel ? nstripes : 1;
+}
+
+/**
+ * @brief Computes the local threshold of a CV_8U image, shared by the Mat and UMat overloads of Tracking::adaptiveBinarisation. With IsDifference, the image is the saturated difference image - subtrahend, computed on the fly by the integral pass and by the threshold pass so that the background subtracted image is never stored.
+ */
+template <bool IsDifference>
+void adaptiveThresholdImage(const Mat &image, const Mat &subtrahend, Mat &binary, int radius, int offset, bool isParallel) {
+  auto pixel = [](const uchar *in, const uchar *sub, int x) -> int {
+    if constexpr (IsDifference) {
+      return std::max(in[x] - sub[x], 0);
+    }
+    else {
+      return in[x];
+    }
+  };
+
+  // Integral image with a row and a column of zeros on the top and left edges, as computed by cv::integral.
+  // The rows are summed in parallel, then the columns are accumulated in parallel by stripes of columns,
+  // each stripe walks down the rows. The unsigned sums wrap around identically whatever the order.
+  Mat sum;
+  sum.create(image.rows + 1, image.cols + 1, CV_32S);
+  std::fill(sum.ptr<unsigned int>(0), sum.ptr<unsigned int>(0) + sum.cols, 0u);
+  parallel_for_(
+      Range(0, image.rows), [&](const Range &range) {
+        for (int y = range.start; y < range.end; y++) {
+          const uchar *in = image.ptr<uchar>(y);
+          const uchar *sub = (IsDifference) ? subtrahend.ptr<uchar>(y) : nullptr;
+          unsigned int *row = sum.ptr<unsigned int>(y + 1);
+          unsigned int rowSum = 0;
+          row[0] = 0;
+          for (int x = 0; x < image.cols; x++) {
+            rowSum += pixel(in, sub, x);
+            row[x + 1] = rowSum;
+          }
+        }
+      },
+      loopStripes(isParallel));
+  parallel_for_(
+      Range(1, image.cols + 1), [&](const Range &range) {
+        for (int y = 1; y < image.rows; y++) {
+          const unsigned int *above = sum.ptr<unsigned int>(y);
+          unsigned int *row = sum.ptr<unsigned int>(y + 1);
+          for (int x = range.start; x < range.end; x++) {
+            row[x] += above[x];
+          }
+        }
+      },
+      loopStripes(isParallel));
+  binary.create(image.size(), CV_8U);
+
+  // Each row only reads the integral image, rows are thresholded in parallel.
+  // The local sums are computed with unsigned arithmetic: the integral image can wrap around
+  // on very large images but the difference stays exact as long as the window sum fits in 32 bits.
+  parallel_for_(
+      Range(0, image.rows), [&](const Range &range) {
+        for (int y = range.start; y < range.end; y++) {
+          int yTop = std::max(y - radius, 0);
+          int yBottom = std::min(y + radius + 1, image.rows);
+          const unsigned int *top = sum.ptr<unsigned int>(yTop);
+          const unsigned int *bottom = sum.ptr<unsigned int>(yBottom);
+          const uchar *in = image.ptr<uchar>(y);
+          const uchar *sub = (IsDifference) ? subtrahend.ptr<uchar>(y) : nullptr;
+          uchar *out = binary.ptr<uchar>(y);
+          for (int x = 0; x < image.cols; x++) {
+            int xLeft = std::max(x - radius, 0);
+            int xRight = std::min(x + radius + 1, image.cols);
+            int64 area = int64(xRight - xLeft) * (yBottom - yTop);
+            int64 localSum = int64(bottom[xRight] - bottom[xLeft] - top[xRight] + top[xLeft]);
+            out[x] = (int64(pixel(in, sub, x) - offset) * area > localSum) ? 255 : 0;
+          }
+        }
+      },
+      loopStripes(isParallel));
+}
+
+/**
+ * @brief Grows a reusable buffer so that it can hold an image of size, returns 1 if the buffer was reallocated and 0 otherwise.
+ */
+size_t growBuffer(Mat &buffer, const Size &size) {
+  if (buffer.rows < size.height || buffer.cols < size.width) {
+    buffer.create(std::max(buffer.rows, size.height), std::max(buffer.cols, size.width), CV_8U);
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Clears a reusable vector and reserves room for size elements, returns 1 if the vector was reallocated and 0 otherwise.
+ */
+template <typename T>
+size_t reserveBuffer(vector<T> &buffer, size_t size) {
+  buffer.clear();
+  if (buffer.capacity() < size) {
+    buffer.reserve(size);
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Resizes a reusable vector, returns 1 if the vector was reallocated and 0 otherwise.
+ */
+template <typename T>
+size_t resizeBuffer(vector<T> &buffer, size_t size) {
+  size_t capacity = buffer.capacity();
+  buffer.resize(size);
+  return buffer.capacity() != capacity;
+}
+
+/**
+ * @brief Number of rows of the stripes labelled in parallel by the tiled connected components detector. The labels of a stripe of a very large image still fit in the cache.
+ */
+constexpr int stripeHeight = 64;
+
+/**
+ * @brief Finds the external contours of a binary image in a reusable list of contours. findContours resizes the contours already in the list, the capacity of each contour is recorded to count the contours it had to reallocate.
+ * @param[in] image Binary image CV_8U.
+ * @param[in, out] contours Reusable list of contours.
+ * @param[in, out] capacities Capacities of the contours after the previous call.
+ * @return The number of buffers allocated.
+ */
+size_t findContoursBuffer(InputArray image, vector<vector<Point>> &contours, vector<size_t> &capacities) {
+  size_t capacity = contours.capacity();
+  findContours(image, contours, RETR_EXTERNAL, CHAIN_APPROX_NONE);
+  size_t allocations = (contours.capacity() != capacity);
+
+  allocations += (capacities.capacity() < contours.size());
+  capacities.resize(contours.size(), 0);
+  for (size_t i = 0; i < contours.size(); i++) {
+    if (contours[i].capacity() != capacities[i]) {
+      capacities[i] = contours[i].capacity();
+      allocations++;
+    }
+  }
+  return allocations;
+}
+
+/**
+ * @brief Computes the equivalent ellipse of an object from its moments without allocating, see Tracking::objectInformation.
+ */
+array<double, 5> ellipseInformation(const Moments &moment) {
+  double x = moment.m10 / moment.m00;
+  double y = moment.m01 / moment.m00;
+
+  double i = moment.mu20;
+  double j = moment.mu11;
+  double k = moment.mu02;
+
+  double orientation = 0;
+  if (i + j - k != 0) {
+    orientation = (0.5 * atan((2 * j) / (i - k)) + (i < k) * (M_PI * 0.5));
+    orientation += 2 * M_PI * (orientation < 0);
+    orientation = (2 * M_PI - orientation);
+  }
+
+  double majAxis = 2 * pow((((i + k) + pow((i - k) * (i - k) + 4 * j * j, 0.5)) * 0.5) / moment.m00, 0.5);
+  double minAxis = 2 * pow((((i + k) - pow((i - k) * (i - k) + 4 * j * j, 0.5)) * 0.5) / moment.m00, 0.5);
+
+  return {x, y, orientation, majAxis, minAxis};
+}
+
+/**
+ * @brief Projects the pixels of an object on its major axis, the projection is binned in columns of one pixel as the column sums of the rotated image used by Tracking::objectDirection. u is the coordinate of a pixel along the major axis, the one it would have in the image rotated to have the object orientation as the x axis.
+ * @param[in] object Binary image CV_8U of the object.
+ * @param[in] parameter Equivalent ellipse of the object, see ellipseInformation.
+ * @param[out] projection Sum of the pixels of each column u, the column u = 0 is at the index ceil(hypot(rows, cols)) + 1.
+ * @param[in, out] sums If IsSplit, the moments {m00, m10, m01, m20, m11, m02} of the halves u < 0 and u >= 0 are added, unused otherwise.
+ */
+template <bool IsSplit>
+void projectObject(const Mat &object, const array<double, 5> &parameter, vector<double> &projection, int64 (&sums)[2][6]) {
+  double cosAngle = cos(parameter[2]);
+  double sinAngle = sin(parameter[2]);
+  double shift = ceil(hypot(object.rows, object.cols)) + 1;
+  projection.assign(2 * static_cast<size_t>(shift) + 1, 0);
+  for (int y = 0; y < object.rows; y++) {
+    const uchar *row = object.ptr<uchar>(y);
+    double dy = y - parameter[1];
+    for (int x = 0; x < object.cols; x++) {
+      if (row[x] != 0) {
+        double u = cosAngle * (x - parameter[0]) - sinAngle * dy;
+        projection[static_cast<size_t>(u + shift)] += 255;
+        if constexpr (IsSplit) {
+          int64 *m = sums[u >= 0];
+          m[0]++;
+          m[1] += x;
+          m[2] += y;
+          m[3] += int64(x) * x;
+          m[4] += int64(x) * y;
+          m[5] += int64(y) * y;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Reduces an image CV_8U by blocks of scale x scale pixels, keeping the maximum or the minimum of each block. The blocks on the right and bottom edges can be smaller.
+ * @param[in] image Image CV_8U.
+ * @param[in] scale Size of the blocks.
+ * @param[in] isMax True to keep the maximum of each block, false to keep the minimum.
+ * @param[out] pooled Reduced image CV_8U.
+ * @param[in] isParallel False to reduce the image in the calling thread.
+ */
+void poolBlocks(const Mat &image, int scale, bool isMax, Mat &pooled, bool isParallel) {
+  pooled.create((image.rows + scale - 1) / scale, (image.cols + scale - 1) / scale, CV_8U);
+  parallel_for_(
+      Range(0, pooled.rows), [&](const Range &range) {
+        for (int blockY = range.start; blockY < range.end; blockY++) {
+          uchar *out = pooled.ptr<uchar>(blockY);
+          std::fill(out, out + pooled.cols, isMax ? 0 : 255);
+          for (int y = blockY * scale; y < std::min((blockY + 1) * scale, image.rows); y++) {
+            const uchar *row = image.ptr<uchar>(y);
+            for (int blockX = 0; blockX < pooled.cols; blockX++) {
+              uchar value = out[blockX];
+              for (int x = blockX * scale; x < std::min((blockX + 1) * scale, image.cols); x++) {
+                value = isMax ? std::max(value, row[x]) : std::min(value, row[x]);
+              }
+              out[blockX] = value;
+            }
+          }
+        }
+      },
+      loopStripes(isParallel));
+}
+
+/**
+ * @brief Maximal fraction of the image covered by the processed windows, above the whole image is processed.
+ */
+constexpr double maxWindowsCoverage = 0.25;
+
+/**
+ * @brief Merges the overlapping windows until they are disjoint and checks that they cover a small part of the image.
+ * @param[in, out] windows Windows to merge, cleared if they cover too much of the image.
+ * @param[in] size Size of the image.
+ * @return False if the windows cover more than maxWindowsCoverage of the image, true otherwise.
+ */
+bool mergeWindows(vector<Rect> &windows, const Size &size) {
+  // Sort and sweep, the windows are sorted by their left edge and a window is only compared to the next windows that
+  // start before its right edge. The merged windows are marked empty and removed at the end of the sweep. A window that
+  // grew can reach a window swept before it, the sweep is then repeated, usually once.
+  for (bool isMerged = true; isMerged;) {
+    isMerged = false;
+    std::sort(windows.begin(), windows.end(), [](const Rect &a, const Rect &b) { return a.x < b.x; });
+    for (size_t i = 0; i < windows.size(); i++) {
+      for (size_t j = i + 1; j < windows.size() && windows[j].x < windows[i].x + windows[i].width; j++) {
+        if ((windows[i] & windows[j]).area() > 0) {
+          windows[i] |= windows[j];
+          windows[j] = Rect();
+          isMerged = true;
+        }
+      }
+    }
+    windows.erase(std::remove_if(windows.begin(), windows.end(), [](const Rect &a) { return a.empty(); }), windows.end());
+  }
+
+  double coverage = 0;
+  for (const auto &a : windows) {
+    coverage += a.area();
+  }
+  if (coverage > maxWindowsCoverage * size.area()) {
+    windows.clear();
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Returns the maximal number of threads of an OpenMP parallel region, 1 without OpenMP.
+ */
+int threadCount() {
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+/**
+ * @brief Returns the index of the calling thread in an OpenMP parallel region, 0 without OpenMP.
+ */
+int threadIndex() {
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+/**
+ * @brief Sums the distances between the pixels of an image row inside the object (value 255) and the curvature center. Only the runs of object pixels are visited, the distances of each run are computed with SIMD instructions when available.
+ * @param[in] row Pointer to the row.
+ * @param[in] cols Number of pixels in the row.
+ * @param[in] dRow Distance between the curvature center and the row along the first axis.
+ * @param[in] center Coordinate of the curvature center along the second axis.
+ * @param[out] count Number of object pixels in the row.
+ * @return The sum of the distances.
+ */
+double curvatureRow(const uchar *row, int cols, double dRow, double center, int &count) {
+  double dRow2 = dRow * dRow;
+  double sum = 0;
+  count = 0;
+#if CV_SIMD_64F
+  static const double laneIndex[] = {0, 1, 2, 3, 4, 5, 6, 7};
+  const int lanes = v_float64::nlanes;
+  v_float64 vSum = vx_setzero_f64();
+  v_float64 vLaneIndex = vx_load(laneIndex);
+  v_float64 vRow2 = vx_setall_f64(dRow2);
+#endif
+
+  int x = 0;
+  while (x < cols) {
+    if (row[x] != 255) {
+      x++;
+      continue;
+    }
+    int start = x;
+    while (x < cols && row[x] == 255) {
+      x++;
+    }
+    count += x - start;
+
+    int j = start;
+#if CV_SIMD_64F
+    for (; j <= x - lanes; j += lanes) {
+      v_float64 dCol = vx_setall_f64(center - j) - vLaneIndex;
+      vSum += v_sqrt(dCol * dCol + vRow2);
+    }
+#endif
+    for (; j < x; j++) {
+      double dCol = center - j;
+      sum += sqrt(dCol * dCol + dRow2);
+    }
+  }
+
+#if CV_SIMD_64F
+  sum += v_reduce_sum(vSum);
+#endif
+  return sum;
+}
+
+/**
+ * @brief Terms of the cost function, a term is used if its normalization is not 0.
+ */
+enum CostTerm {
+  CostDistance = 1,
+  CostAngle = 2,
+  CostArea = 4,
+  CostPerimeter = 8
+};
+
+/**
+ * @brief Computes the distances and the costs between one previous object and a contiguous range of current objects, with SIMD instructions when available. The unused terms are removed at compile time. The angles are in [0, 2pi], the angle difference is the one of Tracking::angleDifference.
+ * @param[in] previous Position, angle, area and perimeter of the previous object.
+ * @param[in] weights Normalization reciprocals of the distance, angle, area and perimeter terms.
+ * @param[in] x, y, angle, area, perimeter Features of the current objects.
+ * @param[in] count Number of current objects.
+ * @param[out] distance Distance between the previous object and each current object.
+ * @param[out] cost Cost of each pair.
+ */
+template <int Terms>
+void costRow(const array<double, 5> &previous, const array<double, 4> &weights, const double *x, const double *y, const double *angle, const double *area, const double *perimeter, int count, double *distance, double *cost) {
+  const double twoPi = 2 * M_PI;
+  int j = 0;
+#if CV_SIMD_64F
+  const int lanes = v_float64::nlanes;
+  const v_float64 vX = vx_setall_f64(previous[0]), vY = vx_setall_f64(previous[1]), vAngle = vx_setall_f64(previous[2]);
+  const v_float64 vArea = vx_setall_f64(previous[3]), vPerimeter = vx_setall_f64(previous[4]);
+  const v_float64 vPi = vx_setall_f64(M_PI), vTwoPi = vx_setall_f64(twoPi), vZero = vx_setzero_f64(), vOne = vx_setall_f64(1);
+  for (; j <= count - lanes; j += lanes) {
+    v_float64 dx = vX - vx_load(x + j);
+    v_float64 dy = vY - vx_load(y + j);
+    v_float64 d = v_sqrt(dx * dx + dy * dy);
+    v_float64 c = vZero;
+    if constexpr ((Terms & CostDistance) != 0) {
+      c += d * vx_setall_f64(weights[0]);
+    }
+    if constexpr ((Terms & CostAngle) != 0) {
+      // The difference plus pi is in [-pi, 3pi], it is wrapped to [0, 2pi) by at most one turn
+      v_float64 a = vAngle - vx_load(angle + j) + vPi;
+      v_float64 turns = a / vTwoPi;
+      a = v_select(turns < vZero, a + vTwoPi, v_select(turns >= vOne, a - vTwoPi, a));
+      c += v_abs(a - vPi) * vx_setall_f64(weights[1]);
+    }
+    if constexpr ((Terms & CostArea) != 0) {
+      c += v_abs(vArea - vx_load(area + j)) * vx_setall_f64(weights[2]);
+    }
+    if constexpr ((Terms & CostPerimeter) != 0) {
+      c += v_abs(vPerimeter - vx_load(perimeter + j)) * vx_setall_f64(weights[3]);
+    }
+    v_store(distance + j, d);
+    v_store(cost + j, c);
+  }
+#endif
+  for (; j < count; j++) {
+    double dx = previous[0] - x[j];
+    double dy = previous[1] - y[j];
+    double d = sqrt(dx * dx + dy * dy);
+    double c = 0;
+    if constexpr ((Terms & CostDistance) != 0) {
+      c += d * weights[0];
+    }
+    if constexpr ((Terms & CostAngle) != 0) {
+      double a = previous[2] - angle[j] + M_PI;
+      double turns = a / twoPi;
+      a = (turns < 0) ? a + twoPi : ((turns >= 1) ? a - twoPi : a);
+      c += abs(a - M_PI) * weights[1];
+    }
+    if constexpr ((Terms & CostArea) != 0) {
+      c += abs(previous[3] - area[j]) * weights[2];
+    }
+    if constexpr ((Terms & CostPerimeter) != 0) {
+      c += abs(previous[4] - perimeter[j]) * weights[3];
+    }
+    distance[j] = d;
+    cost[j] = c;
+  }
+}
+
+/**
+ * @brief Selects the terms of the cost function and computes their normalization reciprocals.
+ * @param[in] normalizations Normalizations of the distance, angle, area and perimeter terms, 0 if the term is not used.
+ * @param[out] weights Normalization reciprocals, 0 for the terms that are not used.
+ * @return The CostTerm mask of the used terms.
+ */
+int costTerms(const array<double, 4> &normalizations, array<double, 4> &weights) {
+  int terms = 0;
+  for (int k = 0; k < 4; k++) {
+    weights[k] = (normalizations[k] != 0) ? 1. / normalizations[k] : 0;
+    terms |= (normalizations[k] != 0) ? (1 << k) : 0;
+  }
+  return terms;
+}
+
+using CostRowFunction = void (*)(const array<double, 5> &, const array<double, 4> &, const double *, const double *, const double *, const double *, const double *, int, double *, double *);
+
+/**
+ * @brief Returns the costRow instantiation of each combination of terms.
+ */
+template <int... Terms>
+constexpr array<CostRowFunction, sizeof...(Terms)> costRowTable(std::integer_sequence<int, Terms...>) {
+  return {&costRow<Terms>...};
+}
+constexpr array<CostRowFunction, 16> costRows = costRowTable(std::make_integer_sequence<int, 16>());
+
+/**
+ * @brief Registers an image in place, shared by the Mat and UMat overloads of Tracking::registration.
+ */
+template <typename T>
+void registerImage(T imageReference, T &frame, int method) {
+  switch (method) {
+    // Simple registration by phase correlation
+    case 0: {
+      frame.convertTo(frame, CV_32FC1);
+      imageReference.convertTo(imageReference, CV_32FC1);
+
+      // Downsamples the image to accelerate the registration
+      vector<T> framesDownSampled;
+      vector<T> imagesReferenceDownSampled;
+      buildPyramid(frame, framesDownSampled, 4);
+      buildPyramid(imageReference, imagesReferenceDownSampled, 4);
+
+      for (size_t i = framesDownSampled.size(); i > 0; i--) {
+        // Simple phase correlation registration
+        Point2d shift = phaseCorrelate(framesDownSampled[i - 1], imagesReferenceDownSampled[i - 1]);
+        Mat H = (Mat_<float>(2, 3) << 1.0, 0.0, shift.x, 0.0, 1.0, shift.y);
+        warpAffine(framesDownSampled[i - 1], framesDownSampled[i - 1], H, framesDownSampled[i - 1].size());
+      }
+      frame.convertTo(frame, CV_8U);
+      break;
+    }
+      // ECC images alignment
+      // !!! This can throw an error if the algo do not converge
+    case 1: {
+      frame.convertTo(frame, CV_32FC1);
+      imageReference.convertTo(imageReference, CV_32FC1);
+
+      // Downsamples the image to accelerate the registration
+      vector<T> framesDownSampled;
+      vector<T> imagesReferenceDownSampled;
+      buildPyramid(frame, framesDownSampled, 4);
+      buildPyramid(imageReference, imagesReferenceDownSampled, 4);
+
+      for (size_t i = framesDownSampled.size(); i > 0; i--) {
+        // Simple phase correlation registration
+        const int warpMode = MOTION_EUCLIDEAN;
+        Mat warpMat = Mat::eye(2, 3, CV_32F);
+        TermCriteria criteria(TermCriteria::COUNT + TermCriteria::EPS, 5000, 1e-5);
+        findTransformECC(imagesReferenceDownSampled[i - 1], framesDownSampled[i - 1], warpMat, warpMode, criteria);
+        // Gets the transformation from downsampled images
+        warpAffine(framesDownSampled[i - 1], framesDownSampled[i - 1], warpMat, framesDownSampled[i - 1].size(), INTER_LINEAR + WARP_INVERSE_MAP);
+      }
+      frame.convertTo(frame, CV_8U);
+      break;
+    }
+    // Features based registration
+    // To do: make an extra argument to the function to add directly a descriptor set avoiding to recalculate the same if the image of reference doesn't change
+    case 2: {
+      frame.convertTo(frame, CV_8U);
+      imageReference.convertTo(imageReference, CV_8U);
+
+      vector<KeyPoint> keypointsFrame, keypointsRef;
+      Mat descriptorsFrame, descriptorsRef;
+      vector<DMatch> matches;
+      const double featureNumber = 500;
+
+      Ptr<Feature2D> orb = ORB::create(featureNumber);
+      orb->detectAndCompute(frame, Mat(), keypointsFrame, descriptorsFrame);
+      orb->detectAndCompute(imageReference, Mat(), keypointsRef, descriptorsRef);
+
+      Ptr<DescriptorMatcher> matcher = DescriptorMatcher::create("BruteForce-Hamming");
+      matcher->match(descriptorsFrame, descriptorsRef, matches, Mat());
+
+      vector<Point2f> pointsFrame, pointsRef;
+      pointsFrame.reserve(featureNumber);
+      pointsRef.reserve(featureNumber);
+      for (size_t i = 0; i < matches.size(); i++) {
+        pointsFrame.push_back(keypointsFrame[matches[i].queryIdx].pt);
+        pointsRef.push_back(keypointsRef[matches[i].trainIdx].pt);
+      }
+
+      Mat h = findHomography(pointsFrame, pointsRef, RANSAC);
+      warpPerspective(frame, frame, h, frame.size());
+
+      frame.convertTo(frame, CV_8U);
+      break;
+    }
+  }
+}
+
+}  // namespace
+
 /**
  * @class Tracking
  *
@@ -85,19 +643,35 @@ Point2d Tracking::curvatureCenter(const Point3d &tail, const Point3d &head) cons
  * @brief Computes the radius of curvature of the object defined as the inverse of the mean distance between each pixel of the object, and the center of the curvature. The center of curvature is defined as the intersection of the two minor axes of the head and tail ellipse.
  * @param[in] center Center of the curvature.
  * @param[in] image Binary image CV_8U.
+ * @param[in] isParallel Splits the rows between the threads, false when called from a loop that is already parallel.
  * @return Radius of curvature.
  */
-double Tracking::curvature(Point2d center, const Mat &image) const {
+double Tracking::curvature(Point2d center, const Mat &image, bool isParallel) const {
+  // Each row is summed in its own slot and the slots are summed in the row order,
+  // the result is the same whatever the number of threads. The buffers of the calling
+  // thread are shared by reference with the worker threads that fill the rows.
+  thread_local vector<double> rowDistanceBuffer;
+  thread_local vector<int> rowCountBuffer;
+  vector<double> &rowDistance = rowDistanceBuffer;
+  vector<int> &rowCount = rowCountBuffer;
+  rowDistance.assign(image.rows, 0);
+  rowCount.assign(image.rows, 0);
+
+  // Small objects are processed in the calling thread
+  parallel_for_(
+      Range(0, image.rows), [&](const Range &range) {
+        for (int y = range.start; y < range.end; y++) {
+          rowDistance[y] = curvatureRow(image.ptr<uchar>(y), image.cols, center.x - y, center.y, rowCount[y]);
+        }
+      },
+      loopStripes(m_isParallel && isParallel, image.rows / 128.));
+
   double d = 0;
   double count = 0;
-
-  image.forEach<uchar>(
-      [&d, &count, center](uchar &pixel, const int position[]) -> void {
-        if (pixel == 255) {  // if inside object
-          d += pow(pow(center.x - float(position[0]), 2) + pow(center.y - float(position[1]), 2), 0.5);
-          count += 1;
-        }
-      });
+  for (int y = 0; y < image.rows; y++) {
+    d += rowDistance[y];
+    count += rowCount[y];
+  }
   return count / d;
 }
 
@@ -143,27 +717,18 @@ double Tracking::angleDifference(double alpha, double beta) {
  * @return The equivalent ellipse parameters: the object center of mass coordinate and its orientation.
  * @note: This function computes the object orientation, not its direction.
  */
-vector<double> Tracking::objectInformation(const UMat &image) const {
-  Moments moment = moments(image);
-
-  double x = moment.m10 / moment.m00;
-  double y = moment.m01 / moment.m00;
-
-  double i = moment.mu20;
-  double j = moment.mu11;
-  double k = moment.mu02;
-
-  double orientation = 0;
-  if (i + j - k != 0) {
-    orientation = (0.5 * atan((2 * j) / (i - k)) + (i < k) * (M_PI * 0.5));
-    orientation += 2 * M_PI * (orientation < 0);
-    orientation = (2 * M_PI - orientation);
-  }
-
-  double majAxis = 2 * pow((((i + k) + pow((i - k) * (i - k) + 4 * j * j, 0.5)) * 0.5) / moment.m00, 0.5);
-  double minAxis = 2 * pow((((i + k) - pow((i - k) * (i - k) + 4 * j * j, 0.5)) * 0.5) / moment.m00, 0.5);
+vector<double> Tracking::objectInformation(InputArray image) const {
+  return objectInformation(moments(image));
+}
 
-  return {x, y, orientation, majAxis, minAxis};
+/**
+ * @brief Computes the equivalent ellipse of an object from its moments. This is an overloaded function to reuse moments already computed by the detector.
+ * @param[in] moment Moments of the object image.
+ * @return The equivalent ellipse parameters: the object center of mass coordinate and its orientation.
+ */
+vector<double> Tracking::objectInformation(const Moments &moment) const {
+  array<double, 5> information = ellipseInformation(moment);
+  return vector<double>(information.begin(), information.end());
 }
 
 /**
@@ -172,39 +737,58 @@ vector<double> Tracking::objectInformation(const UMat &image) const {
  * @param[in, out] information The parameters of the object (x coordinate, y coordinate, orientation).
  * @return True if the direction angle is the orientation angle. False if the direction angle is the orientation angle plus pi.
  */
-bool Tracking::objectDirection(const UMat &image, vector<double> &information) const {
+bool Tracking::objectDirection(InputArray image, vector<double> &information) const {
   // Computes the distribution of the image on the horizontal axis.
-
-  vector<double> projection;
+  thread_local vector<double> projection;
   reduce(image, projection, 0, REDUCE_SUM);
+  if (projectionDirection(projection)) {
+    information[2] = modul(information[2] - M_PI);
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Computes the skewness of the distribution of an object along its major axis, see objectDirection.
+ * @param[in] projection Sum of the pixels of the object in each column along its major axis.
+ * @return True if the skewness is positive, the head of the object is then at the left.
+ */
+bool Tracking::projectionDirection(const vector<double> &projection) {
+  if (projection.empty()) {
+    return false;
+  }
 
-  vector<double> distribution;  // tmp
-  distribution.reserve(projection.size());
+  // The distribution counts each column index (it + 1) a number of times proportional to the projection,
+  // quantized to one hundredth of its maximum. Its moments are computed from these weights without
+  // expanding the distribution.
   double ccMax = *max_element(projection.begin(), projection.end()) / 100;
-  for (size_t it = 0; it < projection.size(); ++it) {
-    int cc = static_cast<int>(projection[it]);
-    for (int jt = 0; jt < cc / ccMax; ++jt) {
-      distribution.push_back((double)(it + 1));
-    }
+  if (!(ccMax > 0)) {
+    return false;
   }
+  auto weight = [&ccMax](double value) {
+    double ratio = static_cast<int>(value) / ccMax;
+    return (ratio > 0) ? ceil(ratio) : 0.;
+  };
 
-  double mean = accumulate(distribution.begin(), distribution.end(), 0) / double(distribution.size());
+  double count = 0, mean = 0;
+  for (size_t it = 0; it < projection.size(); ++it) {
+    double w = weight(projection[it]);
+    count += w;
+    mean += w * double(it + 1);
+  }
+  mean /= count;
 
   double sd = 0, skew = 0;
-
-  for (size_t it = 0; it < distribution.size(); ++it) {
-    sd += pow(distribution[it] - mean, 2);
-    skew += pow(distribution[it] - mean, 3);
+  for (size_t it = 0; it < projection.size(); ++it) {
+    double w = weight(projection[it]);
+    double d = double(it + 1) - mean;
+    sd += w * d * d;
+    skew += w * d * d * d;
   }
 
-  sd = pow(sd / ((double)distribution.size() - 1), 0.5);
-  skew *= (1 / (((double)distribution.size() - 1) * pow(sd, 3)));
-
-  if (skew > 0) {
-    information[2] = modul(information[2] - M_PI);
-    return true;
-  }
-  return false;
+  sd = pow(sd / (count - 1), 0.5);
+  skew *= (1 / ((count - 1) * pow(sd, 3)));
+  return skew > 0;
 }
 
 /**
@@ -291,242 +875,1017 @@ UMat Tracking::backgroundExtraction(VideoReader &video, int n, const int method,
  * @param[in] method The method of registration: 0 = simple (phase correlation), 1 = ECC, 2 = Features based.
  */
 void Tracking::registration(UMat imageReference, UMat &frame, const int method) {
-  switch (method) {
-    // Simple registration by phase correlation
-    case 0: {
-      frame.convertTo(frame, CV_32FC1);
-      imageReference.convertTo(imageReference, CV_32FC1);
+  registerImage(imageReference, frame, method);
+}
 
-      // Downsamples the image to accelerate the registration
-      vector<UMat> framesDownSampled;
-      vector<UMat> imagesReferenceDownSampled;
-      buildPyramid(frame, framesDownSampled, 4);
-      buildPyramid(imageReference, imagesReferenceDownSampled, 4);
+/**
+ * @brief Register two images. This is an overloaded function for the CPU backends.
+ * @param[in] imageReference The reference image for the registration.
+ * @param[in, out] frame The image to register.
+ * @param[in] method The method of registration: 0 = simple (phase correlation), 1 = ECC, 2 = Features based.
+ */
+void Tracking::registration(Mat imageReference, Mat &frame, const int method) {
+  registerImage(imageReference, frame, method);
+}
 
-      for (size_t i = framesDownSampled.size(); i > 0; i--) {
-        // Simple phase correlation registration
-        Point2d shift = phaseCorrelate(framesDownSampled[i - 1], imagesReferenceDownSampled[i - 1]);
-        Mat H = (Mat_<float>(2, 3) << 1.0, 0.0, shift.x, 0.0, 1.0, shift.y);
-        warpAffine(framesDownSampled[i - 1], framesDownSampled[i - 1], H, framesDownSampled[i - 1].size());
+/**
+ * @brief Binarizes the image by thresholding.
+ * @param[in, out] frame The image to binarize.
+ * @param[in] backgroundColor If equals to 'w' the thresholded image will be inverted, if equal to 'b' it will not be inverted.
+ * @param[in] value The value at which to threshold the image.
+ */
+void Tracking::binarisation(UMat &frame, char backgroundColor, int value) {
+  thresholdImage(frame, backgroundColor, value);
+}
+
+/**
+ * @brief Binarizes the image by thresholding. This is an overloaded function for the CPU backends.
+ * @param[in, out] frame The image to binarize.
+ * @param[in] backgroundColor If equals to 'w' the thresholded image will be inverted, if equal to 'b' it will not be inverted.
+ * @param[in] value The value at which to threshold the image.
+ */
+void Tracking::binarisation(Mat &frame, char backgroundColor, int value) {
+  thresholdImage(frame, backgroundColor, value);
+}
+
+/**
+ * @brief Binarizes the image by local thresholding. A pixel belongs to an object if its value is greater than the mean of its (2*radius + 1) x (2*radius + 1) neighborhood plus an offset. The local mean is computed in O(1) per pixel from the integral image, the neighborhood is clamped at the image borders. This corrects the uneven illumination (vignetting) that remains after the background subtraction. There is no OpenCL kernel, the image is downloaded, binarized by the Mat overload on the host and uploaded back.
+ * @param[in, out] frame The background subtracted image to binarize, objects have to be brighter than the background.
+ * @param[in] radius The radius of the neighborhood in pixels, has to be lower than 2048 to avoid overflowing the local sum.
+ * @param[in] offset The value above the local mean at which to threshold the image.
+ * @param[in] isParallel False to threshold the image in the calling thread.
+ */
+void Tracking::adaptiveBinarisation(UMat &frame, int radius, int offset, bool isParallel) {
+  Mat image;
+  frame.copyTo(image);
+  adaptiveBinarisation(image, radius, offset, isParallel);
+  image.copyTo(frame);
+}
+
+/**
+ * @brief Binarizes the image by local thresholding. This is an overloaded function for the CPU backends.
+ * @param[in, out] frame The background subtracted image to binarize, objects have to be brighter than the background.
+ * @param[in] radius The radius of the neighborhood in pixels, has to be lower than 2048 to avoid overflowing the local sum.
+ * @param[in] offset The value above the local mean at which to threshold the image.
+ * @param[in] isParallel False to threshold the image in the calling thread.
+ */
+void Tracking::adaptiveBinarisation(Mat &frame, int radius, int offset, bool isParallel) {
+  frame.convertTo(frame, CV_8U);
+
+  Mat binary;
+  adaptiveThresholdImage<false>(frame, Mat(), binary, radius, offset, isParallel);
+  frame = binary;
+}
+
+/**
+ * @brief Subtracts two images and binarizes the difference by local thresholding in the same passes, the background subtracted image is never stored. The result is the one of subtract(image, subtrahend) followed by adaptiveBinarisation. There is no OpenCL kernel, the images are downloaded, processed by the Mat overload on the host and the binary image is uploaded back.
+ * @param[in] image The image CV_8U from which subtrahend is subtracted.
+ * @param[in] subtrahend The image CV_8U subtracted from image, the negative differences are set to 0.
+ * @param[out] binary The binary image CV_8U.
+ * @param[in] radius The radius of the neighborhood in pixels, has to be lower than 2048 to avoid overflowing the local sum.
+ * @param[in] offset The value above the local mean at which to threshold the image.
+ * @param[in] isParallel False to threshold the image in the calling thread.
+ */
+void Tracking::adaptiveBinarisation(const UMat &image, const UMat &subtrahend, UMat &binary, int radius, int offset, bool isParallel) {
+  Mat minuend, subtracted, result;
+  image.copyTo(minuend);
+  subtrahend.copyTo(subtracted);
+  adaptiveBinarisation(minuend, subtracted, result, radius, offset, isParallel);
+  result.copyTo(binary);
+}
+
+/**
+ * @brief Subtracts two images and binarizes the difference by local thresholding in the same passes. This is an overloaded function for the CPU backends.
+ * @param[in] image The image CV_8U from which subtrahend is subtracted.
+ * @param[in] subtrahend The image CV_8U subtracted from image, the negative differences are set to 0.
+ * @param[out] binary The binary image CV_8U.
+ * @param[in] radius The radius of the neighborhood in pixels, has to be lower than 2048 to avoid overflowing the local sum.
+ * @param[in] offset The value above the local mean at which to threshold the image.
+ * @param[in] isParallel False to threshold the image in the calling thread.
+ */
+void Tracking::adaptiveBinarisation(const Mat &image, const Mat &subtrahend, Mat &binary, int radius, int offset, bool isParallel) {
+  adaptiveThresholdImage<true>(image, subtrahend, binary, radius, offset, isParallel);
+}
+
+/**
+ * @brief Finds the windows of the image that can contain an object. The image and the background are reduced by blocks, keeping for each block the bounds that maximize the difference between the image and the background. A block where this upper bound of the difference is below the threshold can not contain any object pixel. The windows are the bounding boxes of the groups of candidate blocks padded by margin pixels, the overlapping windows are merged.
+ * @param[in] frame Image CV_8U.
+ * @param[in] background Background image CV_8U, its reduction is computed once and reused while the background does not change.
+ * @param[in] isDarkObjects True if the difference is the background minus the image, false if it is the image minus the background.
+ * @param[in] value Threshold of the difference.
+ * @param[in] scale Size of the blocks.
+ * @param[in] margin Minimal distance in pixels between an object pixel and the edges of its window.
+ * @param[out] windows Disjoint windows in the frame of reference of the image, each object is entirely inside one window.
+ * @return False if the windows cover too much of the image and the whole image has to be processed, true otherwise.
+ */
+bool Tracking::coarseWindows(const Mat &frame, const Mat &background, bool isDarkObjects, int value, int scale, int margin, vector<Rect> &windows) const {
+  CoarseScratch &coarse = m_coarse;
+  windows.clear();
+
+  // The difference in a block is at most the maximum of the background minus the minimum of the image for dark objects
+  if (coarse.source != background.data || coarse.scale != scale || coarse.isDarkObjects != isDarkObjects) {
+    poolBlocks(background, scale, isDarkObjects, coarse.background, m_isParallel);
+    coarse.source = background.data;
+    coarse.scale = scale;
+    coarse.isDarkObjects = isDarkObjects;
+  }
+  poolBlocks(frame, scale, !isDarkObjects, coarse.frame, m_isParallel);
+  (isDarkObjects) ? subtract(coarse.background, coarse.frame, coarse.candidates) : subtract(coarse.frame, coarse.background, coarse.candidates);
+  threshold(coarse.candidates, coarse.candidates, value, 255, THRESH_BINARY);
+
+  // Pads the candidate blocks so that the pixels within margin of an object are in the same window
+  int radius = (margin + scale - 1) / scale;
+  dilate(coarse.candidates, coarse.candidates, getStructuringElement(MORPH_RECT, Size(2 * radius + 1, 2 * radius + 1)));
+  int labelCount = connectedComponentsWithStats(coarse.candidates, coarse.labels, coarse.stats, coarse.centroids, 8, CV_32S);
+  Rect image(0, 0, frame.cols, frame.rows);
+  for (int i = 1; i < labelCount; i++) {
+    windows.push_back(Rect(coarse.stats.at<int>(i, CC_STAT_LEFT) * scale, coarse.stats.at<int>(i, CC_STAT_TOP) * scale, coarse.stats.at<int>(i, CC_STAT_WIDTH) * scale, coarse.stats.at<int>(i, CC_STAT_HEIGHT) * scale) & image);
+  }
+
+  return mergeWindows(windows, frame.size());
+}
+
+/**
+ * @brief Finds the windows of the image around the objects of the previous image. An object is matched only if it moved less than the maximal distance, a window is centered on the previous position of each object and extends by the maximal distance, the object length and the margin. The overlapping windows are merged.
+ * @param[in] objects Objects of the previous image in the frame of reference of the region of interest.
+ * @param[in] spot Index of the position used for the matching, 0 for the head, 1 for the tail and 2 for the body.
+ * @param[in] maxDistance Maximal distance between two positions of an object.
+ * @param[in] offset Top left corner of the region of interest in the image.
+ * @param[in] size Size of the image.
+ * @param[in] margin Minimal distance in pixels between an object pixel and the edges of its window.
+ * @param[out] windows Disjoint windows in the frame of reference of the image.
+ * @return False if the windows cover too much of the image and the whole image has to be processed, true otherwise.
+ */
+bool Tracking::predictionWindows(const TrackStore &objects, int spot, double maxDistance, const Point &offset, const Size &size, int margin, vector<Rect> &windows) const {
+  windows.clear();
+  Rect image(Point(0, 0), size);
+  const vector<double> &x = objects.x(spot), &y = objects.y(spot);
+  const vector<double> &body = objects.fields[TrackStore::bodyMajorAxisLength], &head = objects.fields[TrackStore::headMajorAxisLength], &tail = objects.fields[TrackStore::tailMajorAxisLength];
+  for (size_t i = 0; i < objects.size(); i++) {
+    // The major axis of the body, or of the head and the tail if the body is not extracted, is half the object length
+    double length = 2 * max({body[i], 2 * head[i], 2 * tail[i]});
+    int radius = int(ceil(maxDistance + length)) + margin;
+    Point center(int(round(x[i])) + offset.x, int(round(y[i])) + offset.y);
+    Rect window = Rect(center.x - radius, center.y - radius, 2 * radius + 1, 2 * radius + 1) & image;
+    if (!window.empty()) {
+      windows.push_back(window);
+    }
+  }
+
+  return mergeWindows(windows, size);
+}
+
+/**
+ * @brief Detects the objects in the binary image, only inside the windows if the preprocessing only processed windows of the image. With the change driven processing, the objects of the previous image outside the windows are kept.
+ * @param[out] out The objects parameters, see objectPosition.
+ */
+void Tracking::detectObjects(TrackStore &out) {
+  if (!m_isWindowed) {
+    objectPosition(m_binaryFrame, param_minArea, param_maxArea, param_detector, param_features, out);
+    return;
+  }
+
+  out.clear();
+
+  // The objects that do not intersect the windows grown over the previous objects did not change
+  ChangeState &change = m_change;
+  if (m_isIncremental) {
+    growWindows(m_windows);
+    auto isOutside = [this](const Rect &box) { return none_of(m_windows.begin(), m_windows.end(), [&box](const Rect &a) { return (a & box).area() > 0; }); };
+    change.boxes.erase(remove_if(change.boxes.begin(), change.boxes.end(), [&isOutside](const Rect &a) { return !isOutside(a); }), change.boxes.end());
+    size_t count = 0;
+    for (size_t i = 0; i < change.objects.size(); i++) {
+      if (isOutside(change.objectBoxes[i])) {
+        out.push_back(change.objects[i]);
+        change.objects[count] = change.objects[i];
+        change.objectBoxes[count++] = change.objectBoxes[i];
       }
-      frame.convertTo(frame, CV_8U);
-      break;
     }
-      // ECC images alignment
-      // !!! This can throw an error if the algo do not converge
-    case 1: {
-      frame.convertTo(frame, CV_32FC1);
-      imageReference.convertTo(imageReference, CV_32FC1);
+    change.objects.resize(count);
+    change.objectBoxes.resize(count);
+  }
+
+  // The head and the tail are extracted together and stay at 0 if they are not extracted
+  size_t positionStart = (param_features & (FeatureHead | FeatureTail | FeatureCurvature)) ? 0 : 2;
+  for (const Rect &window : m_windows) {
+    objectPosition(m_binaryFrame(window), param_minArea, param_maxArea, param_detector, param_features, m_windowOut);
+    if (m_isIncremental) {
+      detectionBoxes(param_detector, window.tl(), change.objectBoxes, change.boxes);
+    }
+
+    // Positions in the frame of reference of the image
+    for (size_t i = 0; i < m_windowOut[0].size(); i++) {
+      array<Point3d, 7> object;
+      for (size_t k = 0; k < m_windowOut.size(); k++) {
+        object[k] = m_windowOut[k][i];
+        if (k >= positionStart && k < 3) {
+          object[k].x += window.x;
+          object[k].y += window.y;
+        }
+      }
+      out.push_back(object);
+      if (m_isIncremental) {
+        change.objects.push_back(object);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Appends the bounding boxes of the objects found by the last call to objectPosition.
+ * @param[in] detector The objects detector of the call.
+ * @param[in] offset Offset added to the boxes.
+ * @param[in, out] objects Boxes of the selected objects, in the order of the objects.
+ * @param[in, out] components Boxes of all the objects, including the objects filtered by their area.
+ */
+void Tracking::detectionBoxes(int detector, const Point &offset, vector<Rect> &objects, vector<Rect> &components) const {
+  for (const auto &a : m_arena.selected) {
+    objects.push_back(a.box + offset);
+  }
+  if (detector != 0) {
+    for (size_t i = 1; i < m_arena.components.size(); i++) {
+      const Component &c = m_arena.components[i];
+      components.push_back(Rect(c.left + offset.x, c.top + offset.y, c.right - c.left + 1, c.bottom - c.top + 1));
+    }
+  }
+  else {
+    for (const auto &a : m_arena.contours) {
+      components.push_back(boundingRect(a) + offset);
+    }
+  }
+}
+
+/**
+ * @brief Grows the windows over the objects of the previous image that touch them and merges the touching windows. An object pixel next to a window then belongs to the window, the objects inside a window are not connected to any pixel outside.
+ * @param[in, out] windows Windows where the binary image changed, in the frame of reference of the region of interest.
+ */
+void Tracking::growWindows(vector<Rect> &windows) const {
+  for (bool isGrown = true; isGrown;) {
+    isGrown = false;
+    for (size_t i = 0; i < windows.size(); i++) {
+      Rect neighborhood(windows[i].x - 1, windows[i].y - 1, windows[i].width + 2, windows[i].height + 2);
+      for (const auto &a : m_change.boxes) {
+        if ((neighborhood & a).area() > 0 && (windows[i] & a) != a) {
+          windows[i] |= a;
+          isGrown = true;
+        }
+      }
+      for (size_t j = i + 1; j < windows.size(); j++) {
+        if ((neighborhood & windows[j]).area() > 0) {
+          windows[i] |= windows[j];
+          windows.erase(windows.begin() + j);
+          isGrown = true;
+          j = i;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Subtracts the background, binarizes and applies the morphological operation in the windows m_windows of the image, the windows are processed as isolated images and m_binary is 0 outside the windows.
+ * @param[in] frame Image CV_8U.
+ * @param[in] background Background image CV_8U.
+ * @param[in] element Structuring element of the morphological operation, empty if there is no morphological operation.
+ * @param[in] margin Minimal distance in pixels between an object pixel and the edges of its window.
+ * @param[in] isChecked True to check that no pixel above the threshold is closer than margin to an edge of a window inside the image.
+ * @return False if the check failed and the windows can not be used, true otherwise.
+ */
+bool Tracking::processWindows(const Mat &frame, const Mat &background, const Mat &element, int margin, bool isChecked) {
+  if (m_binary.size() != frame.size()) {
+    m_binary = Mat::zeros(frame.size(), CV_8U);
+  }
+  else {
+    for (const auto &a : m_processedWindows) {
+      m_binary(a).setTo(0);
+    }
+  }
+  m_processedWindows.assign(m_windows.begin(), m_windows.end());
+
+  for (const auto &a : m_windows) {
+    Mat binary = m_binary(a);
+    (statusBinarisation) ? (subtract(background(a), frame(a), binary)) : (subtract(frame(a), background(a), binary));
+    binarisation(binary, 'b', param_thresh);
+
+    // An object on an edge can continue outside the window, the edges on the image borders are not checked
+    if (isChecked) {
+      int width = min(margin, a.width);
+      int height = min(margin, a.height);
+      bool isTouching = (a.x > 0 && countNonZero(binary.colRange(0, width)) > 0) || (a.br().x < frame.cols && countNonZero(binary.colRange(a.width - width, a.width)) > 0);
+      isTouching = isTouching || (a.y > 0 && countNonZero(binary.rowRange(0, height)) > 0) || (a.br().y < frame.rows && countNonZero(binary.rowRange(a.height - height, a.height)) > 0);
+      if (isTouching) {
+        return false;
+      }
+    }
+
+    if (!element.empty()) {
+      morphologyEx(binary, binary, param_morphOperation, element, Point(-1, -1), 1, BORDER_CONSTANT | BORDER_ISOLATED);
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Change driven processing, only the tiles of the image that changed since their last processing are binarized again. A pixel is compared to its value at the last processing of its tile, the binary image of a tile can not change while the largest change of its pixels is below the smallest distance between its difference to the background and the threshold. The morphological operation is applied around the changed tiles. Keeps the whole binary image in m_binary and stores the windows where the binary image changed in m_windows.
+ * @param[in] frame Image CV_8U.
+ * @param[in] background Background image CV_8U.
+ * @param[in] element Structuring element of the morphological operation, empty if there is no morphological operation.
+ */
+void Tracking::processChanges(const Mat &frame, const Mat &background, const Mat &element) {
+  ChangeState &change = m_change;
+  int tile = param_changeTile;
+  Rect image(0, 0, frame.cols, frame.rows);
+  vector<Rect> &tiles = change.tiles;
+  tiles.clear();
+
+  // The largest change of the pixels of each tile, the changed tiles are grouped in windows
+  bool isReset = (change.source != background.data || change.reference.size() != frame.size());
+  if (!isReset) {
+    absdiff(frame, change.reference, change.difference);
+    poolBlocks(change.difference, tile, true, change.pooled, m_isParallel);
+    compare(change.pooled, change.tolerance, change.changed, CMP_GE);
+    int labelCount = connectedComponentsWithStats(change.changed, change.labels, change.stats, change.centroids, 8, CV_32S);
+    for (int i = 1; i < labelCount; i++) {
+      tiles.push_back(Rect(change.stats.at<int>(i, CC_STAT_LEFT) * tile, change.stats.at<int>(i, CC_STAT_TOP) * tile, change.stats.at<int>(i, CC_STAT_WIDTH) * tile, change.stats.at<int>(i, CC_STAT_HEIGHT) * tile) & image);
+    }
+    isReset = !mergeWindows(tiles, frame.size());
+  }
+
+  // The whole image is processed for the first image, after a change of the background or of the parameters and if too many tiles changed
+  if (isReset) {
+    change.source = background.data;
+    change.reference.create(frame.size(), CV_8U);
+    change.threshold.create(frame.size(), CV_8U);
+    change.tolerance.create((frame.rows + tile - 1) / tile, (frame.cols + tile - 1) / tile, CV_8U);
+    change.boxes.clear();
+    change.objects.clear();
+    change.objectBoxes.clear();
+    m_binary.create(frame.size(), CV_8U);
+    tiles.assign(1, image);
+  }
+
+  // The tolerance of a tile is the smallest change of one of its pixels that crosses the threshold
+  for (const auto &a : tiles) {
+    Mat binary = change.threshold(a);
+    (statusBinarisation) ? (subtract(background(a), frame(a), binary)) : (subtract(frame(a), background(a), binary));
+    subtract(binary, Scalar(param_thresh), change.above);
+    subtract(Scalar(param_thresh + 1), binary, change.below);
+    add(change.above, change.below, change.above);
+    poolBlocks(change.above, tile, false, change.pooled, m_isParallel);
+    change.pooled.copyTo(change.tolerance(Rect(a.x / tile, a.y / tile, change.pooled.cols, change.pooled.rows)));
+    binarisation(binary, 'b', param_thresh);
+    frame(a).copyTo(change.reference(a));
+  }
+
+  // The morphological operation reads up to two kernel radius around a pixel, the pixels farther from the changed tiles did
+  // not change. The operation is applied with this context around them, the intermediate image is only wrong in the context.
+  int radius = (element.empty()) ? 0 : 2 * param_kernelSize;
+  m_windows.clear();
+  for (const auto &a : tiles) {
+    Rect changed = Rect(a.x - radius, a.y - radius, a.width + 2 * radius, a.height + 2 * radius) & image;
+    if (element.empty()) {
+      change.threshold(changed).copyTo(m_binary(changed));
+    }
+    else {
+      Rect context = Rect(changed.x - radius, changed.y - radius, changed.width + 2 * radius, changed.height + 2 * radius) & image;
+      morphologyEx(change.threshold(context), change.morphed, param_morphOperation, element);
+      change.morphed(changed - context.tl()).copyTo(m_binary(changed));
+    }
+    m_windows.push_back(changed);
+  }
+
+  // The binary image is not 0 outside the windows, it is entirely cleared if the next image is processed by windows
+  m_processedWindows.assign(1, image);
+}
+
+/**
+ * @brief Subtracts the background, binarizes the image, applies the morphological operation and crops the region of interest. Stores the binary image in m_binaryFrame and the cropped image in m_visuFrame. Instantiated with Mat for the CPU backends and with UMat for the OpenCL backend, the contours are always extracted on a Mat. With the CPU backends and a global threshold, only windows of the image are processed if possible: the windows around the changes found by processChanges with the change driven processing, the binary image of the previous image is then kept outside the windows. Otherwise the binary image is 0 outside the windows, the windows around the previous objects found by predictionWindows if isPredicted is true or the windows found by coarseWindows with the coarse detection.
+ * @param[in] frame The image to process.
+ * @param[in] background The background image.
+ * @param[in] isPredicted True to process only the windows around the objects of the previous image, m_isPredicted is set to true if these windows are used.
+ */
+template <typename T>
+void Tracking::preprocessing(const T &frame, const T &background, bool isPredicted) {
+  bool isMorphology = (param_kernelSize != 0 && param_morphOperation != 8);
+  Mat element;
+  if (isMorphology) {
+    element = getStructuringElement(param_kernelType, Size(2 * param_kernelSize + 1, 2 * param_kernelSize + 1), Point(param_kernelSize, param_kernelSize));
+  }
+  Rect roi = (m_ROI.width != 0 || m_ROI.height != 0) ? m_ROI : Rect(0, 0, frame.cols, frame.rows);
+
+  // Only the windows that can contain an object are processed at full resolution. The morphological operation reads up
+  // to two kernel radius around a pixel, the objects are kept farther from the windows edges.
+  m_isWindowed = false;
+  m_isPredicted = false;
+  m_isIncremental = false;
+  if constexpr (std::is_same<T, Mat>::value) {
+    int margin = (isMorphology) ? 2 * param_kernelSize + 1 : 1;
+    if (param_adaptiveThresh == 0) {
+      if (param_changeTile > 0) {
+        processChanges(frame, background, element);
+        m_isIncremental = true;
+        m_isWindowed = true;
+      }
+      else if (isPredicted && predictionWindows(m_tracks, param_spot, param_lo, roi.tl(), frame.size(), margin, m_windows) && processWindows(frame, background, element, margin, true)) {
+        m_isPredicted = true;
+        m_isWindowed = true;
+      }
+      else if (param_coarseScale > 1 && coarseWindows(frame, background, statusBinarisation, param_thresh, param_coarseScale, margin, m_windows)) {
+        m_isWindowed = processWindows(frame, background, element, margin, false);
+      }
+    }
+
+    if (m_isWindowed) {
+      // Windows in the frame of reference of the region of interest
+      size_t count = 0;
+      for (const auto &a : m_windows) {
+        Rect window = a & roi;
+        if (!window.empty()) {
+          m_windows[count++] = window - roi.tl();
+        }
+      }
+      m_windows.resize(count);
+      m_binaryFrame = m_binary(roi);
+      m_visuFrame = frame(roi);
+      return;
+    }
+  }
+
+  // The adaptive threshold subtracts the background in its own passes, the background subtracted image is not stored
+  T binary;
+  if (param_adaptiveThresh > 0) {
+    (statusBinarisation) ? adaptiveBinarisation(background, frame, binary, param_adaptiveThresh, param_thresh, m_isParallel) : adaptiveBinarisation(frame, background, binary, param_adaptiveThresh, param_thresh, m_isParallel);
+  }
+  else {
+    (statusBinarisation) ? (subtract(background, frame, binary)) : (subtract(frame, background, binary));
+    binarisation(binary, 'b', param_thresh);
+  }
+
+  if (isMorphology) {
+    morphologyEx(binary, binary, param_morphOperation, element);
+  }
+
+  if constexpr (std::is_same<T, UMat>::value) {
+    binary(roi).copyTo(m_binaryFrame);
+    frame(roi).copyTo(m_visuFrame);
+  }
+  else {
+    m_binaryFrame = binary(roi);
+    m_visuFrame = frame(roi);
+  }
+}
+
+/**
+ * @brief Registers the image, detects the objects and stores them in m_detections. When the number of objects is known and every object was found in the previous image, only the windows around the previous objects are processed. The whole image is processed if the number of objects differs or if an object moved farther than the maximal distance.
+ * @param[in, out] frame The image to process, registered in place if the registration is activated.
+ * @param[in] background The background image.
+ */
+template <typename T>
+void Tracking::processImage(T &frame, const T &background) {
+  if (param_registration != 0) {
+    registration(background, frame, param_registration - 1);
+  }
+
+  bool isPredicted = param_n > 0 && m_tracks.size() == size_t(param_n) && all_of(m_tracks.lost.begin(), m_tracks.lost.end(), [](int a) { return a == 0; });
+  preprocessing(frame, background, isPredicted);
+  detectObjects(m_detections);
+  if (!m_isPredicted) {
+    return;
+  }
+
+  // The matching rejects the objects farther than the maximal distance, each previous object has to be in reach
+  const vector<double> &x = m_detections.x(param_spot), &y = m_detections.y(param_spot);
+  bool isFound = m_detections.size() == size_t(param_n);
+  for (size_t i = 0; isFound && i < m_tracks.size(); i++) {
+    double a = m_tracks.x(param_spot)[i], b = m_tracks.y(param_spot)[i];
+    isFound = false;
+    for (size_t j = 0; !isFound && j < x.size(); j++) {
+      isFound = pow(pow(a - x[j], 2) + pow(b - y[j], 2), 0.5) < param_lo;
+    }
+  }
+  if (!isFound) {
+    preprocessing(frame, background, false);
+    detectObjects(m_detections);
+  }
+}
+
+/**
+ * @brief Extracts the features of one object from its binary image: the head, tail and body ellipses, the curvature, the area and the perimeter. Only the features in the Features mask are computed, the others are set to 0.
+ * @param[in] object Binary image CV_8U of the object cropped to its bounding box.
+ * @param[in] moment Moments of the object image.
+ * @param[in] offset Top left corner of the object bounding box in the frame.
+ * @param[in] area Area of the object.
+ * @param[in] perimeter Perimeter of the object.
+ * @return The object features in the order of objectPosition: {head, tail, body, Point(curvature, area, perimeter), head ellipse, tail ellipse, body ellipse}.
+ */
+template <unsigned int Features>
+array<Point3d, 7> Tracking::objectFeatures(const Mat &object, const Moments &moment, const Point &offset, double area, double perimeter) const {
+  static_assert(!(Features & FeatureCurvature) || ((Features & FeatureHead) && (Features & FeatureTail)), "The curvature needs the head and the tail");
+  array<Point3d, 7> features;
+
+  // Computes the x, y and orientation of the object, in the
+  // frame of reference of ROIFull image.
+  array<double, 5> parameter = ellipseInformation(moment);
+
+  // Checks if the direction is defined. In the case of a perfect circle the direction can be computed and arbitrary set to 0
+  if (parameter[2] != parameter[2]) {
+    parameter[2] = 0;
+  }
 
-      // Downsamples the image to accelerate the registration
-      vector<UMat> framesDownSampled;
-      vector<UMat> imagesReferenceDownSampled;
-      buildPyramid(frame, framesDownSampled, 4);
-      buildPyramid(imageReference, imagesReferenceDownSampled, 4);
+  if constexpr ((Features & FeatureHead) || (Features & FeatureTail)) {
+    // Splits the object along its minor axis passing through the center of mass without rotating the image.
+    // The moments of each half are accumulated in the frame of reference of the object image, and the
+    // projection of the pixels on the major axis gives the direction of the object.
+    thread_local vector<double> projection;
+    int64 sums[2][6] = {};  // {m00, m10, m01, m20, m11, m02} of the halves u < 0 and u >= 0
+    projectObject<true>(object, parameter, projection, sums);
+
+    // If the skewness is positive, the head is at the left (u < 0) and the tail at the right.
+    bool isHeadLeft = projectionDirection(projection);
+    if (isHeadLeft) {
+      parameter[2] = modul(parameter[2] - M_PI);
+    }
+    const int64 *head = sums[isHeadLeft ? 0 : 1];
+    const int64 *tail = sums[isHeadLeft ? 1 : 0];
+    array<double, 5> parameterHead = ellipseInformation(Moments(double(head[0]), double(head[1]), double(head[2]), double(head[3]), double(head[4]), double(head[5]), 0, 0, 0, 0));
+    array<double, 5> parameterTail = ellipseInformation(Moments(double(tail[0]), double(tail[1]), double(tail[2]), double(tail[3]), double(tail[4]), double(tail[5]), 0, 0, 0, 0));
+
+    // The direction of each half is the direction of the object plus the angle between the half major
+    // axis and the object major axis, folded in [-pi/2, pi/2).
+    auto halfDirection = [&parameter](double orientation) {
+      double delta = orientation - parameter[2];
+      delta -= M_PI * floor((delta + 0.5 * M_PI) / M_PI);
+      return modul(delta + parameter[2]);
+    };
+
+    double xHead = parameterHead[0] + offset.x;
+    double yHead = parameterHead[1] + offset.y;
+    double angleHead = halfDirection(parameterHead[2]);
+
+    double xTail = parameterTail[0] + offset.x;
+    double yTail = parameterTail[1] + offset.y;
+    double angleTail = halfDirection(parameterTail[2]);
+
+    if constexpr (Features & FeatureHead) {
+      features[0] = Point3d(xHead + m_ROI.tl().x, yHead + m_ROI.tl().y, angleHead);
+      features[4] = Point3d(parameterHead[3], parameterHead[4], pow(1 - (parameterHead[4] * parameterHead[4]) / (parameterHead[3] * parameterHead[3]), 0.5));
+    }
+    if constexpr (Features & FeatureTail) {
+      features[1] = Point3d(xTail + m_ROI.tl().x, yTail + m_ROI.tl().y, angleTail);
+      features[5] = Point3d(parameterTail[3], parameterTail[4], pow(1 - (parameterTail[4] * parameterTail[4]) / (parameterTail[3] * parameterTail[3]), 0.5));
+    }
 
-      for (size_t i = framesDownSampled.size(); i > 0; i--) {
-        // Simple phase correlation registration
-        const int warpMode = MOTION_EUCLIDEAN;
-        Mat warpMat = Mat::eye(2, 3, CV_32F);
-        TermCriteria criteria(TermCriteria::COUNT + TermCriteria::EPS, 5000, 1e-5);
-        findTransformECC(imagesReferenceDownSampled[i - 1], framesDownSampled[i - 1], warpMat, warpMode, criteria);
-        // Gets the transformation from downsampled images
-        warpAffine(framesDownSampled[i - 1], framesDownSampled[i - 1], warpMat, framesDownSampled[i - 1].size(), INTER_LINEAR + WARP_INVERSE_MAP);
+    // Computes the curvature of the object
+    if constexpr (Features & FeatureCurvature) {
+      double curv = 1. / 1e-16;
+      Point2d radiusCurv = curvatureCenter(Point3d(xTail, yTail, angleTail), Point3d(xHead, yHead, angleHead));
+      if (!std::isnan(radiusCurv.x)) {
+        // Serial, the objects are already split between the threads by objectPosition
+        curv = curvature(radiusCurv, object, false);
       }
-      frame.convertTo(frame, CV_8U);
-      break;
+      features[3].x = curv;
     }
-    // Features based registration
-    // To do: make an extra argument to the function to add directly a descriptor set avoiding to recalculate the same if the image of reference doesn't change
-    case 2: {
-      frame.convertTo(frame, CV_8U);
-      imageReference.convertTo(imageReference, CV_8U);
-
-      vector<KeyPoint> keypointsFrame, keypointsRef;
-      Mat descriptorsFrame, descriptorsRef;
-      vector<DMatch> matches;
-      const double featureNumber = 500;
+  }
+  else {
+    // The direction of the object is given by the skewness of the projection of the pixels on its major axis
+    thread_local vector<double> projection;
+    int64 sums[2][6];
+    projectObject<false>(object, parameter, projection, sums);
+    if (projectionDirection(projection)) {
+      parameter[2] = modul(parameter[2] - M_PI);
+    }
+  }
 
-      Ptr<Feature2D> orb = ORB::create(featureNumber);
-      orb->detectAndCompute(frame, Mat(), keypointsFrame, descriptorsFrame);
-      orb->detectAndCompute(imageReference, Mat(), keypointsRef, descriptorsRef);
+  if constexpr (Features & FeatureBody) {
+    features[2] = Point3d(parameter[0] + offset.x + m_ROI.tl().x, parameter[1] + offset.y + m_ROI.tl().y, parameter[2]);
+    features[6] = Point3d(parameter[3], parameter[4], pow(1 - (parameter[4] * parameter[4]) / (parameter[3] * parameter[3]), 0.5));
+  }
+  if constexpr (Features & FeatureArea) {
+    features[3].y = area;
+  }
+  if constexpr (Features & FeaturePerimeter) {
+    features[3].z = perimeter;
+  }
+  return features;
+}
 
-      Ptr<DescriptorMatcher> matcher = DescriptorMatcher::create("BruteForce-Hamming");
-      matcher->match(descriptorsFrame, descriptorsRef, matches, Mat());
+/**
+ * @brief Accumulates the area, the bounding box and the spatial moments up to the second order of all the labelled objects in one pass over the labels image.
+ * @param[in] labels Labels image CV_32S.
+ * @param[in] rowOffset Row of the labels image in the frame.
+ * @param[in, out] components Components indexed by label, sized to the number of labels.
+ */
+void Tracking::componentStats(const Mat &labels, int rowOffset, vector<Component> &components) {
+  for (auto &a : components) {
+    a = Component();
+  }
 
-      vector<Point2f> pointsFrame, pointsRef;
-      pointsFrame.reserve(featureNumber);
-      pointsRef.reserve(featureNumber);
-      for (size_t i = 0; i < matches.size(); i++) {
-        pointsFrame.push_back(keypointsFrame[matches[i].queryIdx].pt);
-        pointsRef.push_back(keypointsRef[matches[i].trainIdx].pt);
+  // Integer sums are exact
+  for (int y = 0; y < labels.rows; y++) {
+    const int *label = labels.ptr<int>(y);
+    int row = y + rowOffset;
+    for (int x = 0; x < labels.cols; x++) {
+      if (label[x] != 0) {
+        Component &c = components[label[x]];
+        if (c.m00 == 0) {
+          c.top = row;
+          c.firstX = x;
+        }
+        c.m00++;
+        c.m10 += x;
+        c.m01 += row;
+        c.m20 += int64(x) * x;
+        c.m11 += int64(x) * row;
+        c.m02 += int64(row) * row;
+        c.left = std::min(c.left, x);
+        c.right = std::max(c.right, x);
+        c.bottom = row;
       }
-
-      Mat h = findHomography(pointsFrame, pointsRef, RANSAC);
-      warpPerspective(frame, frame, h, frame.size());
-
-      frame.convertTo(frame, CV_8U);
-      break;
     }
   }
 }
 
 /**
- * @brief Binarizes the image by thresholding.
- * @param[in, out] frame The image to binarize.
- * @param[in] backgroundColor If equals to 'w' the thresholded image will be inverted, if equal to 'b' it will not be inverted.
- * @param[in] value The value at which to threshold the image.
+ * @brief Labels the objects of a binary image in the labels buffer and accumulates their area, bounding box and moments in the components buffer.
+ * @param[in] frame Binary image CV_8U.
+ * @param[in] detector 1: the whole image is labelled at once. 2: the image is split in horizontal stripes labelled in parallel, the objects crossing the boundaries between stripes are merged afterward. The objects are the same for both, only the numbering of the labels differs.
+ * @return The number of labels, including the background.
  */
-void Tracking::binarisation(UMat &frame, char backgroundColor, int value) {
-  frame.convertTo(frame, CV_8U);
+int Tracking::labelComponents(const Mat &frame, int detector) const {
+  DetectionArena &arena = m_arena;
+  uchar *labelsData = arena.labels.data;
+
+  if (detector != 2 || frame.rows <= stripeHeight) {
+    int labelCount = connectedComponents(frame, arena.labels, 8, CV_32S);
+    arena.allocations += (arena.labels.data != labelsData);
+    arena.allocations += resizeBuffer(arena.components, labelCount);
+    componentStats(arena.labels, 0, arena.components);
+    return labelCount;
+  }
 
-  if (backgroundColor == 'b') {
-    threshold(frame, frame, value, 255, THRESH_BINARY);
+  // Labels and measures each stripe in parallel, the labels of a stripe are written in place in the labels buffer
+  int stripeCount = (frame.rows + stripeHeight - 1) / stripeHeight;
+  arena.labels.create(frame.size(), CV_32S);
+  arena.allocations += (arena.labels.data != labelsData);
+  arena.allocations += resizeBuffer(arena.stripes, stripeCount);
+  parallel_for_(
+      Range(0, stripeCount), [&](const Range &range) {
+        for (int s = range.start; s < range.end; s++) {
+          StripeScratch &stripe = arena.stripes[s];
+          Range rows(s * stripeHeight, std::min((s + 1) * stripeHeight, frame.rows));
+          Mat labels = arena.labels.rowRange(rows);
+          stripe.labelCount = connectedComponents(frame.rowRange(rows), labels, 8, CV_32S);
+          stripe.allocations += resizeBuffer(stripe.components, stripe.labelCount);
+          componentStats(labels, rows.start, stripe.components);
+        }
+      },
+      loopStripes(m_isParallel));
+
+  // Numbers the labels of all the stripes one after the other
+  int labelTotal = 0;
+  for (auto &a : arena.stripes) {
+    a.firstLabel = labelTotal;
+    labelTotal += a.labelCount;
   }
 
-  if (backgroundColor == 'w') {
-    threshold(frame, frame, value, 255, THRESH_BINARY_INV);
+  // Merges the labels of 8-connected pixels on each side of the boundaries between stripes, the last row of
+  // a stripe is the halo of the next one. The root of each set is its smallest label.
+  vector<int> &parents = arena.parents;
+  arena.allocations += resizeBuffer(parents, labelTotal);
+  std::iota(parents.begin(), parents.end(), 0);
+  auto find = [&parents](int a) {
+    while (parents[a] != a) {
+      parents[a] = parents[parents[a]];
+      a = parents[a];
+    }
+    return a;
+  };
+  for (int s = 1; s < stripeCount; s++) {
+    const int *above = arena.labels.ptr<int>(s * stripeHeight - 1);
+    const int *below = arena.labels.ptr<int>(s * stripeHeight);
+    int aboveFirst = arena.stripes[s - 1].firstLabel;
+    int belowFirst = arena.stripes[s].firstLabel;
+    for (int x = 0; x < frame.cols; x++) {
+      if (below[x] == 0) {
+        continue;
+      }
+      for (int xAbove = std::max(x - 1, 0); xAbove <= std::min(x + 1, frame.cols - 1); xAbove++) {
+        if (above[xAbove] != 0) {
+          int a = find(aboveFirst + above[xAbove]);
+          int b = find(belowFirst + below[x]);
+          if (a != b) {
+            parents[std::max(a, b)] = std::min(a, b);
+          }
+        }
+      }
+    }
+  }
+
+  // Numbers the merged objects, a root is always visited before the other labels of its set
+  vector<int> &finalLabels = arena.finalLabels;
+  arena.allocations += resizeBuffer(finalLabels, labelTotal);
+  std::fill(finalLabels.begin(), finalLabels.end(), 0);
+  int labelCount = 1;
+  for (const auto &stripe : arena.stripes) {
+    for (int i = stripe.firstLabel + 1; i < stripe.firstLabel + stripe.labelCount; i++) {
+      int root = find(i);
+      if (finalLabels[root] == 0) {
+        finalLabels[root] = labelCount++;
+      }
+      finalLabels[i] = finalLabels[root];
+    }
   }
+
+  // Sums the parts of each object, integer sums are exact and do not depend on the stripes
+  arena.allocations += resizeBuffer(arena.components, labelCount);
+  for (auto &a : arena.components) {
+    a = Component();
+  }
+  for (const auto &stripe : arena.stripes) {
+    for (int i = 1; i < stripe.labelCount; i++) {
+      const Component &part = stripe.components[i];
+      Component &c = arena.components[finalLabels[stripe.firstLabel + i]];
+      if (part.top < c.top || (part.top == c.top && part.firstX < c.firstX)) {
+        c.top = part.top;
+        c.firstX = part.firstX;
+      }
+      c.m00 += part.m00;
+      c.m10 += part.m10;
+      c.m01 += part.m01;
+      c.m20 += part.m20;
+      c.m11 += part.m11;
+      c.m02 += part.m02;
+      c.left = std::min(c.left, part.left);
+      c.right = std::max(c.right, part.right);
+      c.bottom = std::max(c.bottom, part.bottom);
+    }
+  }
+
+  // Relabels the stripes with the labels of the merged objects
+  parallel_for_(
+      Range(0, stripeCount), [&](const Range &range) {
+        for (int s = range.start; s < range.end; s++) {
+          const int *finalLabel = &finalLabels[arena.stripes[s].firstLabel];
+          for (int y = s * stripeHeight; y < std::min((s + 1) * stripeHeight, frame.rows); y++) {
+            int *label = arena.labels.ptr<int>(y);
+            for (int x = 0; x < frame.cols; x++) {
+              label[x] = finalLabel[label[x]];
+            }
+          }
+        }
+      },
+      loopStripes(m_isParallel));
+
+  return labelCount;
 }
 
 /**
- * @brief Computes the positions of the objects and extracts the object's features.
+ * @brief Computes the positions of the objects and extracts the object's features. This is the pipeline specialized at compile time for a set of features, the features that are not in the mask are neither computed nor stored.
  * @param[in] frame Binary image CV_8U.
  * @param[in] minSize The minimal size of an object.
  * @param[in] maxSize: The maximal size of an object.
- * @return All the parameters of all the objects formated as follows: one vector, inside of this vector, four vectors for parameters of the head, tail, body and features with number of object size. {  { Point(xHead, yHead, thetaHead), ...}, Point({xTail, yTail, thetaHead), ...}, {Point(xBody, yBody, thetaBody), ...}, {Point(curvature, 0, 0), ...}}
+ * @param[in] detector The objects detector. 0: contours, 1: connected components, 2: tiled connected components.
+ * @param[out] out The objects parameters, see the public overloads. The vectors are reused.
  */
-vector<vector<Point3d>> Tracking::objectPosition(const UMat &frame, int minSize, int maxSize) const {
-  vector<vector<Point>> contours;
-  vector<Point3d> positionHead;
-  vector<Point3d> positionTail;
-  vector<Point3d> positionFull;
-  vector<Point3d> ellipseHead;
-  vector<Point3d> ellipseTail;
-  vector<Point3d> ellipseBody;
-  vector<Point3d> globalParam;
-  UMat dst;
-  Rect roiFull, bbox;
-  UMat RoiFull, RoiHead, RoiTail, rotate;
-  Mat rotMatrix, p, pp;
-  vector<double> parameter;
-  vector<double> parameterHead;
-  vector<double> parameterTail;
-  Point2d radiusCurv;
-
-  findContours(frame, contours, RETR_EXTERNAL, CHAIN_APPROX_NONE);
-
-  size_t reserve = contours.size();
-  positionHead.reserve(reserve);
-  positionTail.reserve(reserve);
-  positionFull.reserve(reserve);
-  ellipseHead.reserve(reserve);
-  ellipseTail.reserve(reserve);
-  ellipseBody.reserve(reserve);
-  globalParam.reserve(reserve);
+template <unsigned int Features, typename Output>
+void Tracking::objectPosition(const Mat &frame, int minSize, int maxSize, int detector, Output &out) const {
+  // The scratch buffers are reset by each step of the detection but keep their memory from the previous images
+  DetectionArena &arena = m_arena;
+
+  if (detector != 0) {
+    // Labels the objects and computes their area, bounding box and moments without tracing any contour
+    int labelCount = labelComponents(frame, detector);
+    arena.allocations += reserveBuffer(arena.selected, labelCount);
+    for (int i = 1; i < labelCount; i++) {
+      const Component &c = arena.components[i];
+      if (c.m00 > minSize && c.m00 < maxSize) {  // Only selects objects minArea << objectArea <<maxArea
+        arena.selected.push_back({i, double(c.m00), Rect(c.left, c.top, c.right - c.left + 1, c.bottom - c.top + 1)});
+      }
+    }
 
-  for (size_t i = 0; i < contours.size(); i++) {
-    double a = contourArea(contours[i]);
-    if (a > minSize && a < maxSize) {  // Only selects objects minArea << objectArea <<maxArea
-
-      // Draws the object in a temporary black image to avoid selecting a
-      // part of another object if two objects are very close.
-      dst = UMat::zeros(frame.size(), CV_8U);
-      drawContours(dst, contours, static_cast<int>(i), Scalar(255, 255, 255), FILLED, 8);
-
-      // Computes the x, y and orientation of the object, in the
-      // frame of reference of ROIFull image.
-      roiFull = boundingRect(contours[i]);
-      RoiFull = dst(roiFull);
-      parameter = objectInformation(RoiFull);
-
-      // Checks if the direction is defined. In the case of a perfect circle the direction can be computed and arbitrary set to 0
-      if (parameter[2] != parameter[2]) {
-        parameter[2] = 0;
+    // Orders the objects by their first pixel in the raster order, the order does not depend on the labelling
+    std::sort(arena.selected.begin(), arena.selected.end(), [&arena](const SelectedObject &a, const SelectedObject &b) {
+      return (a.box.y != b.box.y) ? a.box.y < b.box.y : arena.components[a.index].firstX < arena.components[b.index].firstX;
+    });
+  }
+  else {
+    arena.allocations += findContoursBuffer(frame, arena.contours, arena.contourCapacities);
+    arena.allocations += reserveBuffer(arena.selected, arena.contours.size());
+    for (size_t i = 0; i < arena.contours.size(); i++) {
+      double a = contourArea(arena.contours[i]);
+      if (a > minSize && a < maxSize) {  // Only selects objects minArea << objectArea <<maxArea
+        arena.selected.push_back({static_cast<int>(i), a, boundingRect(arena.contours[i])});
       }
+    }
+  }
+
+  // Grows the buffer of each thread to the largest object before the parallel region,
+  // whatever the scheduling each thread can then draw any object without allocating.
+  int objectCount = static_cast<int>(arena.selected.size());
+  Size maxBox;
+  for (const auto &a : arena.selected) {
+    maxBox.width = std::max(maxBox.width, a.box.width);
+    maxBox.height = std::max(maxBox.height, a.box.height);
+  }
+  if (arena.threads.size() < size_t(threadCount())) {
+    arena.threads.resize(threadCount());
+    arena.allocations++;
+  }
+  for (auto &a : arena.threads) {
+    arena.allocations += growBuffer(a.mask, maxBox);
+  }
+  arena.allocations += resizeBuffer(arena.features, objectCount);
+
+  // Extracts the features of each object in parallel. Objects have different sizes, the dynamic
+  // schedule balances the load between threads. The features are written at the index of the object
+  // so that the output order does not depend on the scheduling.
+  std::exception_ptr error = nullptr;
+#pragma omp parallel for schedule(dynamic) if (m_isParallel)
+  for (int k = 0; k < objectCount; k++) {
+    try {
+      ObjectScratch &scratch = arena.threads[threadIndex()];
+      const SelectedObject &object = arena.selected[k];
+      int i = object.index;
+      double perimeter = 0;
+      Mat RoiFull = scratch.mask(Rect(Point(0, 0), object.box.size()));
+      if (detector != 0) {
+        compare(arena.labels(object.box), i, RoiFull, CMP_EQ);
+
+        // The perimeter is computed by tracing only the boundary of the selected objects
+        if constexpr (Features & FeaturePerimeter) {
+          scratch.allocations += findContoursBuffer(RoiFull, scratch.boundary, scratch.boundaryCapacities);
+          perimeter = (scratch.boundary.empty()) ? 0 : arcLength(scratch.boundary[0], true);
+        }
 
-      // Rotates the image without cropping to have the object orientation as the x axis
-      Point2d center = Point2d(0.5 * RoiFull.cols, 0.5 * RoiFull.rows);
-      rotMatrix = getRotationMatrix2D(center, -(parameter[2] * 180) / M_PI, 1);
-      bbox = RotatedRect(center, RoiFull.size(), static_cast<float>(-(parameter[2] * 180) / M_PI)).boundingRect();
-      rotMatrix.at<double>(0, 2) += bbox.width * 0.5 - center.x;
-      rotMatrix.at<double>(1, 2) += bbox.height * 0.5 - center.y;
-      warpAffine(RoiFull, rotate, rotMatrix, bbox.size());
-
-      // Computes the coordinate of the center of mass of the object in the rotated
-      // image frame of reference.
-      p = (Mat_<double>(3, 1) << parameter[0], parameter[1], 1);
-      pp = rotMatrix * p;
-
-      // Computes the direction of the object. If objectDirection return true, the
-      // head is at the left and the tail at the right.
-      Rect roiHead, roiTail;
-      if (objectDirection(rotate, parameter)) {
-        // Head ellipse. Parameters in the frame of reference of the RoiHead image.
-        roiHead = Rect(0, 0, static_cast<int>(pp.at<double>(0, 0)), rotate.rows);
-        RoiHead = rotate(roiHead);
-        parameterHead = objectInformation(RoiHead);
-
-        // Tail ellipse. Parameters in the frame of reference of ROITail image.
-        roiTail = Rect(static_cast<int>(pp.at<double>(0, 0)), 0, static_cast<int>(rotate.cols - pp.at<double>(0, 0)), rotate.rows);
-        RoiTail = rotate(roiTail);
-        parameterTail = objectInformation(RoiTail);
+        // The moments are converted in the frame of reference of the bounding box, integer arithmetic is exact
+        const Component &c = arena.components[i];
+        int64 x0 = object.box.x, y0 = object.box.y;
+        Moments moment(double(c.m00), double(c.m10 - x0 * c.m00), double(c.m01 - y0 * c.m00), double(c.m20 - 2 * x0 * c.m10 + x0 * x0 * c.m00), double(c.m11 - x0 * c.m01 - y0 * c.m10 + x0 * y0 * c.m00), double(c.m02 - 2 * y0 * c.m01 + y0 * y0 * c.m00), 0, 0, 0, 0);
+        arena.features[k] = objectFeatures<Features>(RoiFull, moment, object.box.tl(), object.area, perimeter);
       }
       else {
-        // Head ellipse. Parameters in the frame of reference of the RoiHead image.
-        roiHead = Rect(static_cast<int>(pp.at<double>(0, 0)), 0, static_cast<int>(rotate.cols - pp.at<double>(0, 0)), rotate.rows);
-        RoiHead = rotate(roiHead);
-        parameterHead = objectInformation(RoiHead);
-
-        // Tail ellipse. Parameters in the frame of reference of RoiTail image.
-        roiTail = Rect(0, 0, static_cast<int>(pp.at<double>(0, 0)), rotate.rows);
-        RoiTail = rotate(roiTail);
-        parameterTail = objectInformation(RoiTail);
+        // Draws the object in a black image the size of its bounding box to avoid selecting a
+        // part of another object if two objects are very close.
+        RoiFull.setTo(0);
+        drawContours(RoiFull, arena.contours, i, Scalar(255, 255, 255), FILLED, 8, noArray(), INT_MAX, -object.box.tl());
+        if constexpr (Features & FeaturePerimeter) {
+          perimeter = arcLength(arena.contours[i], true);
+        }
+        arena.features[k] = objectFeatures<Features>(RoiFull, moments(RoiFull), object.box.tl(), object.area, perimeter);
+      }
+    }
+    catch (...) {
+      // Exceptions can not leave the parallel region, the first one is rethrown afterward
+#pragma omp critical
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  if constexpr (std::is_same<Output, TrackStore>::value) {
+    out.clear();
+    for (const auto &a : arena.features) {
+      out.push_back(a);
+    }
+  }
+  else {
+    if (out.size() != 7) {
+      out.resize(7);
+      arena.allocations++;
+    }
+    for (size_t k = 0; k < out.size(); k++) {
+      arena.allocations += reserveBuffer(out[k], arena.features.size());
+      for (const auto &a : arena.features) {
+        out[k].push_back(a[k]);
       }
+    }
+  }
+}
+
+/**
+ * @brief Computes the positions of the objects and extracts the object's features.
+ * @param[in] frame Binary image CV_8U.
+ * @param[in] minSize The minimal size of an object.
+ * @param[in] maxSize: The maximal size of an object.
+ * @param[in] detector The objects detector. 0: contours, the area is the contour area and the holes inside the objects are filled. 1: connected components, the area is the number of pixels of the object. 2: connected components labelled by horizontal stripes in parallel, for very large images, the output is the same as 1.
+ * @param[in] features Mask of the features to extract, see Tracking::Feature. The head and the tail are always extracted together and the body is always extracted, the features that are not extracted are set to 0.
+ * @return All the parameters of all the objects formated as follows: one vector, inside of this vector, four vectors for parameters of the head, tail, body and features with number of object size. {  { Point(xHead, yHead, thetaHead), ...}, Point({xTail, yTail, thetaHead), ...}, {Point(xBody, yBody, thetaBody), ...}, {Point(curvature, 0, 0), ...}}
+ */
+vector<vector<Point3d>> Tracking::objectPosition(const Mat &frame, int minSize, int maxSize, int detector, unsigned int features) const {
+  vector<vector<Point3d>> out;
+  objectPosition(frame, minSize, maxSize, detector, features, out);
+  return out;
+}
 
-      // Gets all the parameters in the frame of reference of RoiFull image.
-      invertAffineTransform(rotMatrix, rotMatrix);
-      p = (Mat_<double>(3, 1) << parameterHead[0] + roiHead.tl().x, parameterHead[1] + roiHead.tl().y, 1);
-      pp = rotMatrix * p;
+/**
+ * @brief Computes the positions of the objects and extracts the object's features in a reusable output. This is an overloaded function that does not allocate when out already holds enough memory.
+ * @param[in] frame Binary image CV_8U.
+ * @param[in] minSize The minimal size of an object.
+ * @param[in] maxSize: The maximal size of an object.
+ * @param[in] detector The objects detector, see the overload returning the parameters.
+ * @param[in] features Mask of the features to extract, see Tracking::Feature.
+ * @param[out] out The objects parameters, see the overload returning the parameters.
+ */
+void Tracking::objectPosition(const Mat &frame, int minSize, int maxSize, int detector, unsigned int features, vector<vector<Point3d>> &out) const {
+  selectObjectPosition(frame, minSize, maxSize, detector, features, out);
+}
 
-      double xHead = pp.at<double>(0, 0) + roiFull.tl().x;
-      double yHead = pp.at<double>(1, 0) + roiFull.tl().y;
-      double angleHead = parameterHead[2] - M_PI * (parameterHead[2] > M_PI);
-      angleHead = modul(angleHead + parameter[2] + M_PI * (abs(angleHead) > 0.5 * M_PI));  // Computes the direction
+/**
+ * @brief Computes the positions of the objects and extracts the object's features directly in a store. This is an overloaded function that does not allocate when out already holds enough memory, the objects are given the ids 0 to n - 1.
+ * @param[in] frame Binary image CV_8U.
+ * @param[in] minSize The minimal size of an object.
+ * @param[in] maxSize: The maximal size of an object.
+ * @param[in] detector The objects detector, see the overload returning the parameters.
+ * @param[in] features Mask of the features to extract, see Tracking::Feature.
+ * @param[out] out The objects features, one array per feature.
+ */
+void Tracking::objectPosition(const Mat &frame, int minSize, int maxSize, int detector, unsigned int features, TrackStore &out) const {
+  selectObjectPosition(frame, minSize, maxSize, detector, features, out);
+}
 
-      p = (Mat_<double>(3, 1) << parameterTail[0] + roiTail.tl().x, parameterTail[1] + roiTail.tl().y, 1);
-      pp = rotMatrix * p;
-      double xTail = pp.at<double>(0, 0) + roiFull.tl().x;
-      double yTail = pp.at<double>(1, 0) + roiFull.tl().y;
-      double angleTail = parameterTail[2] - M_PI * (parameterTail[2] > M_PI);
-      angleTail = modul(angleTail + parameter[2] + M_PI * (abs(angleTail) > 0.5 * M_PI));  // Computes the direction
+/**
+ * @brief Dispatches to the objectPosition pipeline specialized for the requested features.
+ * @param[in] frame Binary image CV_8U.
+ * @param[in] minSize The minimal size of an object.
+ * @param[in] maxSize: The maximal size of an object.
+ * @param[in] detector The objects detector, see the overload returning the parameters.
+ * @param[in] features Mask of the features to extract, see Tracking::Feature.
+ * @param[out] out The objects features.
+ */
+template <typename Output>
+void Tracking::selectObjectPosition(const Mat &frame, int minSize, int maxSize, int detector, unsigned int features, Output &out) const {
+  // Dispatches to the pipeline specialized for the requested features. The head and the tail are
+  // computed by the same pass over the object and the body is needed by both.
+  constexpr unsigned int body = FeatureBody;
+  constexpr unsigned int halves = FeatureHead | FeatureTail | FeatureBody;
+  bool isHalves = features & (FeatureHead | FeatureTail | FeatureCurvature);
+  bool isCurvature = features & FeatureCurvature;
+  bool isArea = features & FeatureArea;
+  bool isPerimeter = features & FeaturePerimeter;
+
+  if (!isHalves) {
+    if (isArea && isPerimeter) return objectPosition<body | FeatureArea | FeaturePerimeter, Output>(frame, minSize, maxSize, detector, out);
+    if (isArea) return objectPosition<body | FeatureArea, Output>(frame, minSize, maxSize, detector, out);
+    if (isPerimeter) return objectPosition<body | FeaturePerimeter, Output>(frame, minSize, maxSize, detector, out);
+    return objectPosition<body, Output>(frame, minSize, maxSize, detector, out);
+  }
+  if (isCurvature) {
+    if (isArea && isPerimeter) return objectPosition<FeatureAll, Output>(frame, minSize, maxSize, detector, out);
+    if (isArea) return objectPosition<halves | FeatureCurvature | FeatureArea, Output>(frame, minSize, maxSize, detector, out);
+    if (isPerimeter) return objectPosition<halves | FeatureCurvature | FeaturePerimeter, Output>(frame, minSize, maxSize, detector, out);
+    return objectPosition<halves | FeatureCurvature, Output>(frame, minSize, maxSize, detector, out);
+  }
+  if (isArea && isPerimeter) return objectPosition<halves | FeatureArea | FeaturePerimeter, Output>(frame, minSize, maxSize, detector, out);
+  if (isArea) return objectPosition<halves | FeatureArea, Output>(frame, minSize, maxSize, detector, out);
+  if (isPerimeter) return objectPosition<halves | FeaturePerimeter, Output>(frame, minSize, maxSize, detector, out);
+  return objectPosition<halves, Output>(frame, minSize, maxSize, detector, out);
+}
 
-      // Computes the curvature of the object
-      double curv = 1. / 1e-16;
-      radiusCurv = curvatureCenter(Point3d(xTail, yTail, angleTail), Point3d(xHead, yHead, angleHead));
-      if (radiusCurv.x != NAN) {  //
-        curv = curvature(radiusCurv, RoiFull.getMat(ACCESS_READ));
-      }
+/**
+ * @brief Returns the number of buffers allocated by the objects detection since the construction of the object. The detection buffers are reused across images, in steady state this number does not change from one image to the next.
+ * @return The number of allocations.
+ */
+size_t Tracking::detectionAllocations() const {
+  size_t allocations = m_arena.allocations;
+  for (const auto &a : m_arena.threads) {
+    allocations += a.allocations;
+  }
+  for (const auto &a : m_arena.stripes) {
+    allocations += a.allocations;
+  }
+  return allocations;
+}
 
-      positionHead.push_back(Point3d(xHead + m_ROI.tl().x, yHead + m_ROI.tl().y, angleHead));
-      positionTail.push_back(Point3d(xTail + m_ROI.tl().x, yTail + m_ROI.tl().y, angleTail));
-      positionFull.push_back(Point3d(parameter[0] + roiFull.tl().x + m_ROI.tl().x, parameter[1] + roiFull.tl().y + m_ROI.tl().y, parameter[2]));
-      ellipseHead.push_back(Point3d(parameterHead[3], parameterHead[4], pow(1 - (parameterHead[4] * parameterHead[4]) / (parameterHead[3] * parameterHead[3]), 0.5)));
-      ellipseTail.push_back(Point3d(parameterTail[3], parameterTail[4], pow(1 - (parameterTail[4] * parameterTail[4]) / (parameterTail[3] * parameterTail[3]), 0.5)));
-      ellipseBody.push_back(Point3d(parameter[3], parameter[4], pow(1 - (parameter[4] * parameter[4]) / (parameter[3] * parameter[3]), 0.5)));
+/**
+ * @brief Converts a list of features names separated by commas into a mask of features. The names are head, tail, body, curvature, area and perimeter. An empty list selects all the features.
+ * @param[in] features List of features names, for example "body,area".
+ * @return The mask of features, see Tracking::Feature.
+ */
+unsigned int Tracking::featureMask(const QString &features) {
+  if (features.trimmed().isEmpty()) {
+    return FeatureAll;
+  }
 
-      globalParam.push_back(Point3d(curv, a, arcLength(contours[i], true)));
+  const QMap<QString, unsigned int> names = {{"head", FeatureHead}, {"tail", FeatureTail}, {"body", FeatureBody}, {"curvature", FeatureCurvature}, {"area", FeatureArea}, {"perimeter", FeaturePerimeter}};
+  unsigned int mask = 0;
+  for (const auto &a : features.split(",", Qt::SkipEmptyParts)) {
+    QString name = a.trimmed().toLower();
+    if (names.contains(name)) {
+      mask |= names.value(name);
     }
-
-    else if (contourArea(contours[i]) >= maxSize && contourArea(contours[i]) < 3 * maxSize) {
+    else {
+      qWarning() << "Unknown feature" << name << "ignored";
     }
   }
-
-  return {positionHead, positionTail, positionFull, globalParam, ellipseHead, ellipseTail, ellipseBody};
+  return mask;
 }
 
 /**
- * @brief Computes a cost function and use a global optimization association to associate targets between images. Method adapted from: "An effective and robust method for Tracking multiple fish in video image based on fish head detection" YQ Chen et al. Uses the Hungarian method implemented by Cong Ma, 2016 "https://github.com/mcximing/hungarian-algorithm-cpp" adapted from the Matlab implementation by Markus Buehren "https://fr.mathworks.com/matlabcentral/fileexchange/6543-functions-for-the-rectangular-assignment-problem".
+ * @brief Computes a cost function and use a global optimization association to associate targets between images. Method adapted from: "An effective and robust method for Tracking multiple fish in video image based on fish head detection" YQ Chen et al. Uses the Hungarian method implemented by Cong Ma, 2016 "https://github.com/mcximing/hungarian-algorithm-cpp" adapted from the Matlab implementation by Markus Buehren "https://fr.mathworks.com/matlabcentral/fileexchange/6543-functions-for-the-rectangular-assignment-problem", or the shortest augmenting path solvers of Assignment on the whole cost matrix or only on the pairs closer than LO. The graph of the pairs closer than LO is split in independent components solved in parallel.
  * @param[in] prevPos The vector of objects parameters at the previous image.
  * @param[in] pos The vector of objects parameters at the current image that we want to sort in order to conserve objects identity.
  * @param[in] LENGTH The typical displacement of an object in pixels.
@@ -535,54 +1894,331 @@ vector<vector<Point3d>> Tracking::objectPosition(const UMat &frame, int minSize,
  * @return The assignment vector containing the new index position to sort the pos vector.
  */
 vector<int> Tracking::costFunc(const vector<vector<Point3d>> &prevPos, const vector<vector<Point3d>> &pos, double LENGTH, double ANGLE, double LO, double AREA, double PERIMETER) const {
-  int n = static_cast<int>(prevPos[0].size());
-  int m = static_cast<int>(pos[0].size());
+  TrackStore previous, current;
+  previous.load(prevPos);
+  current.load(pos);
+  return costFunc(previous, current, LENGTH, ANGLE, LO, AREA, PERIMETER);
+}
+
+/**
+ * @brief Computes a cost function and use a global optimization association to associate targets between images, see the overload above. The features are read from the contiguous arrays of the stores. If the motion gating is enabled, the distance of each previous object is measured from its predicted position, within a gate adapted to the error of its previous predictions.
+ * @param[in] prevPos Objects at the previous image.
+ * @param[in] pos Objects at the current image that we want to sort in order to conserve objects identity.
+ * @param[in] LENGTH The typical displacement of an object in pixels.
+ * @param[in] ANGLE The typical reorientation angle in radians.
+ * @param[in] LO The maximal assignment distance in pixels.
+ * @return The assignment vector containing the new index position to sort the pos vector.
+ */
+vector<int> Tracking::costFunc(const TrackStore &prevPos, const TrackStore &pos, double LENGTH, double ANGLE, double LO, double AREA, double PERIMETER) const {
+  int n = static_cast<int>(prevPos.size());
+  int m = static_cast<int>(pos.size());
   vector<int> assignment;
 
   if (n == 0) {
     assignment = {};
   }
   else {
-    vector<vector<double>> costMatrix(n, vector<double>(m));
-    vector<pair<int, int>> distances;
-
-    for (int i = 0; i < n; ++i) {  // Loop on previous objects
-      Point3d prevCoord = prevPos[param_spot][i];
-      Point3d prevData = prevPos[3][i];
-      for (int j = 0; j < m; ++j) {  // Loop on current objects
-        Point3d coord = pos[param_spot][j];
-        Point3d data = pos[3][j];
-        double distanceDiff = pow(pow(prevCoord.x - coord.x, 2) + pow(prevCoord.y - coord.y, 2), 0.5);
-        double angleDiff = abs(angleDifference(prevCoord.z, coord.z));
-        double areaDiff = abs(prevData.y - data.y);
-        double perimeterDiff = abs(prevData.z - data.z);
-        double c = -1;
-        if (distanceDiff < LO) {
-          c = divide(distanceDiff, LENGTH) + divide(angleDiff, ANGLE) + divide(areaDiff, AREA) + divide(perimeterDiff, PERIMETER);
-          costMatrix[i][j] = c;
-          distances.push_back({i, j});
+    // Candidates of each previous object, the pairs farther than LO are never assigned
+    CostScratch &scratch = m_costScratch;
+    vector<int> &rowStart = scratch.rowStart;
+    vector<int> &candidates = scratch.candidates;
+    vector<double> &costs = scratch.costs;
+    rowStart.assign(n + 1, 0);
+    candidates.clear();
+    costs.clear();
+
+    // Uniform grid over the current objects, sorted by cell. The cells are at least LO wide, a pair closer than LO is in
+    // neighboring cells and each previous object is only compared to the objects of the 3x3 cells around it. The objects
+    // with a non-finite position, for example the head of an object with an empty half, are never candidates.
+    const vector<double> &x = pos.x(param_spot), &y = pos.y(param_spot);
+    double minX = INFINITY, maxX = -INFINITY, minY = INFINITY, maxY = -INFINITY;
+    for (int j = 0; j < m; ++j) {
+      if (std::isfinite(x[j]) && std::isfinite(y[j])) {
+        minX = std::min(minX, x[j]);
+        maxX = std::max(maxX, x[j]);
+        minY = std::min(minY, y[j]);
+        maxY = std::max(maxY, y[j]);
+      }
+    }
+    if (LO > 0 && minX <= maxX) {
+      const vector<double> &prevX = prevPos.x(param_spot), &prevY = prevPos.y(param_spot), &prevAngle = prevPos.angle(param_spot);
+      const vector<double> &prevArea = prevPos.fields[TrackStore::areaBody], &prevPerimeter = prevPos.fields[TrackStore::perimeterBody];
+      double cellSize = std::max(LO, 1e-6 * std::max(maxX - minX, maxY - minY));
+      double maxRow = floor((maxY - minY) / cellSize), maxColumn = floor((maxX - minX) / cellSize);
+
+      // Cell of a position, false if the position is not finite or if the 3x3 cells around it are outside the grid and
+      // therefore empty. The cell indexes are then in a range where the conversion and the neighbors do not overflow.
+      auto cellOf = [&](double a, double b, pair<int64, int64> &cell) {
+        double row = floor((b - minY) / cellSize), column = floor((a - minX) / cellSize);
+        if (!(row >= -1 && row <= maxRow + 1 && column >= -1 && column <= maxColumn + 1)) {
+          return false;
+        }
+        cell = {int64(row), int64(column)};
+        return true;
+      };
+      vector<pair<pair<int64, int64>, int>> &cells = scratch.cells;
+      cells.clear();
+      for (int j = 0; j < m; ++j) {
+        pair<int64, int64> cell;
+        if (cellOf(x[j], y[j], cell)) {
+          cells.push_back({cell, j});
+        }
+      }
+      std::sort(cells.begin(), cells.end());
+      int cellCount = static_cast<int>(cells.size());
+
+      // Only the terms with a normalization are computed, the selection of updatingParameters is reused for the
+      // normalizations of the parameters
+      array<double, 4> normalizations = {LENGTH, ANGLE, AREA, PERIMETER};
+      array<double, 4> weights = m_costWeights;
+      int terms = (normalizations == m_costNormalizations) ? m_costTerms : costTerms(normalizations, weights);
+      CostRowFunction costRowFunction = costRows[terms];
+
+      // Features of the current objects in the order of the cells, the objects of 3 neighboring cells are contiguous.
+      // The features of the unused terms are not gathered.
+      auto gather = [&cells, cellCount](bool isUsed, const vector<double> &feature, vector<double> &sorted) {
+        sorted.resize(isUsed ? cellCount : 0);
+        for (size_t k = 0; k < sorted.size(); ++k) {
+          sorted[k] = feature[cells[k].second];
+        }
+      };
+      gather(true, x, scratch.x);
+      gather(true, y, scratch.y);
+      gather((terms & CostAngle) != 0, pos.angle(param_spot), scratch.angle);
+      gather((terms & CostArea) != 0, pos.fields[TrackStore::areaBody], scratch.area);
+      gather((terms & CostPerimeter) != 0, pos.fields[TrackStore::perimeterBody], scratch.perimeter);
+      for (auto &a : scratch.angle) {
+        a = modul(a);
+      }
+      scratch.rowDistance.resize(m);
+      scratch.rowCost.resize(m);
+
+      // With the motion gating, the gate of each previous object is centred on its position predicted at constant
+      // velocity. Its radius is 3 times the square root of the moving average of the squared prediction errors of the
+      // object, scaled by the images since its last detection. The radius is at least param_motionGate and at most LO,
+      // the gate stays in the 3x3 cells around the predicted position. A prediction that is not finite is not used,
+      // a prediction outside the grid has no candidates.
+      bool isPredicted = param_motionGate > 0;
+      for (int i = 0; i < n; ++i) {  // Loop on previous objects
+        rowStart[i] = static_cast<int>(candidates.size());
+        double predictedX = prevX[i], predictedY = prevY[i], radius = LO;
+        if (isPredicted) {
+          double time = prevPos.lost[i] + 1;
+          double nextX = prevX[i] + prevPos.vx[i] * time, nextY = prevY[i] + prevPos.vy[i] * time;
+          if (std::isfinite(nextX) && std::isfinite(nextY)) {
+            predictedX = nextX;
+            predictedY = nextY;
+            radius = std::min(LO, std::max(param_motionGate, 3 * sqrt(prevPos.error[i]) * time));
+          }
+        }
+        array<double, 5> previous = {predictedX, predictedY, ((terms & CostAngle) != 0) ? modul(prevAngle[i]) : 0, prevArea[i], prevPerimeter[i]};
+        pair<int64, int64> cell;
+        if (!cellOf(predictedX, predictedY, cell)) {
+          continue;
+        }
+        for (int64 row = cell.first - 1; row <= cell.first + 1; ++row) {
+          // The 3 cells of a row are contiguous in the sorted cells
+          int first = static_cast<int>(std::lower_bound(cells.begin(), cells.end(), make_pair(make_pair(row, cell.second - 1), INT_MIN)) - cells.begin());
+          int last = static_cast<int>(std::upper_bound(cells.begin() + first, cells.end(), make_pair(make_pair(row, cell.second + 1), INT_MAX)) - cells.begin());
+          int count = last - first;
+          auto range = [first](const vector<double> &a) { return a.empty() ? nullptr : a.data() + first; };
+          costRowFunction(previous, weights, range(scratch.x), range(scratch.y), range(scratch.angle), range(scratch.area), range(scratch.perimeter), count, scratch.rowDistance.data(), scratch.rowCost.data());
+          for (int k = 0; k < count; ++k) {  // Loop on current objects
+            if (scratch.rowDistance[k] < radius) {
+              candidates.push_back(cells[first + k].second);
+              costs.push_back(scratch.rowCost[k]);
+            }
+          }
+        }
+      }
+    }
+
+    rowStart[n] = static_cast<int>(candidates.size());
+
+    // Independent components of the graph of the candidate pairs, the previous objects are the nodes 0 to n - 1 and the
+    // current objects the nodes n to n + m - 1. The assignment of a component does not depend on the other components.
+    vector<int> &parents = scratch.parents;
+    parents.resize(n + m);
+    std::iota(parents.begin(), parents.end(), 0);
+    auto find = [&parents](int a) {
+      while (parents[a] != a) {
+        parents[a] = parents[parents[a]];
+        a = parents[a];
+      }
+      return a;
+    };
+    for (int i = 0; i < n; ++i) {
+      for (int k = rowStart[i]; k < rowStart[i + 1]; ++k) {
+        int a = find(i);
+        int b = find(n + candidates[k]);
+        if (a != b) {
+          parents[std::max(a, b)] = std::min(a, b);
+        }
+      }
+    }
+
+    // Previous and current objects of each component grouped by a counting sort, the objects without candidate are not
+    // assigned
+    vector<int> &componentOf = scratch.componentOf;
+    componentOf.assign(n + m, -1);
+    int componentCount = 0;
+    for (int i = 0; i < n; ++i) {
+      if (rowStart[i + 1] > rowStart[i] && componentOf[find(i)] == -1) {
+        componentOf[find(i)] = componentCount++;
+      }
+    }
+    auto group = [&find, &componentOf, componentCount](int first, int count, vector<int> &start, vector<int> &members) {
+      start.assign(componentCount + 1, 0);
+      for (int a = first; a < first + count; ++a) {
+        int component = componentOf[find(a)];
+        if (component != -1) {
+          start[component + 1]++;
+        }
+      }
+      std::partial_sum(start.begin(), start.end(), start.begin());
+      members.resize(start[componentCount]);
+      for (int a = first; a < first + count; ++a) {
+        int component = componentOf[find(a)];
+        if (component != -1) {
+          members[start[component]++] = a - first;
+        }
+      }
+      for (int c = componentCount; c > 0; --c) {
+        start[c] = start[c - 1];
+      }
+      start[0] = 0;
+    };
+    group(0, n, scratch.componentRowStart, scratch.componentRows);
+    group(n, m, scratch.componentColumnStart, scratch.componentColumns);
+    const vector<int> &componentRowStart = scratch.componentRowStart, &componentRows = scratch.componentRows;
+    const vector<int> &componentColumnStart = scratch.componentColumnStart, &componentColumns = scratch.componentColumns;
+    vector<int> &localColumns = scratch.localColumns;
+    localColumns.resize(m);
+    for (int c = 0; c < componentCount; ++c) {
+      for (int k = componentColumnStart[c]; k < componentColumnStart[c + 1]; ++k) {
+        localColumns[componentColumns[k]] = k - componentColumnStart[c];
+      }
+    }
+
+    // The components are solved in parallel, each thread with its own solver
+    assignment.assign(n, -1);
+    if (m_assignments.size() < size_t(threadCount())) {
+      m_assignments.resize(threadCount());
+    }
+    std::exception_ptr error = nullptr;
+#pragma omp parallel for schedule(dynamic) if (componentCount > 1 && m_isParallel)
+    for (int c = 0; c < componentCount; c++) {
+      try {
+        const int *rows = componentRows.data() + componentRowStart[c];
+        const int *columns = componentColumns.data() + componentColumnStart[c];
+        int rowCount = componentRowStart[c + 1] - componentRowStart[c];
+        int columnCount = componentColumnStart[c + 1] - componentColumnStart[c];
+
+        // A component of one pair is assigned without solver
+        if (rowCount == 1 && columnCount == 1) {
+          assignment[rows[0]] = columns[0];
         }
         else {
-          costMatrix[i][j] = 2e307;
+          assignComponent(rows, rowCount, columns, columnCount, localColumns, rowStart, candidates, costs, m_assignments[threadIndex()], assignment);
+        }
+      }
+      catch (...) {
+#pragma omp critical
+        if (!error) {
+          error = std::current_exception();
         }
       }
     }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  return assignment;
+}
+
+/**
+ * @brief Solves the assignment problem of one component of the graph of the candidate pairs with the selected solver.
+ * @param[in] rows Previous objects of the component.
+ * @param[in] n Number of previous objects of the component.
+ * @param[in] columns Current objects of the component.
+ * @param[in] m Number of current objects of the component.
+ * @param[in] localColumns Index of each current object in the current objects of its component.
+ * @param[in] rowStart Index of the first candidate of each previous object.
+ * @param[in] candidates Current objects closer than LO of all the previous objects.
+ * @param[in] costs Costs of the candidates.
+ * @param[in, out] scratch Solvers and buffers of the calling thread, reused across images.
+ * @param[out] assignment The assignment vector, only the previous objects of the component are written.
+ */
+void Tracking::assignComponent(const int *rows, int n, const int *columns, int m, const vector<int> &localColumns, const vector<int> &rowStart, const vector<int> &candidates, const vector<double> &costs, AssignmentScratch &scratch, vector<int> &assignment) const {
+  vector<int> &localStart = scratch.rowStart;
+  vector<int> &localCandidates = scratch.candidates;
+  vector<double> &localCosts = scratch.costs;
+  vector<int> &localAssignment = scratch.assignment;
+  localStart.assign(n + 1, 0);
+  localCandidates.clear();
+  localCosts.clear();
+  for (int i = 0; i < n; ++i) {
+    for (int k = rowStart[rows[i]]; k < rowStart[rows[i] + 1]; ++k) {
+      localCandidates.push_back(localColumns[candidates[k]]);
+      localCosts.push_back(costs[k]);
+    }
+    localStart[i + 1] = static_cast<int>(localCandidates.size());
+  }
+
+  if (param_solver == 2) {
+    // Sparse shortest augmenting path on the candidates, the other objects are not assigned
+    scratch.solver.solveSparse(n, m, localStart, localCandidates, localCosts, localAssignment);
+  }
+  else {
+    // Pairs closer than LO, row major bitmap checked in constant time after the assignment
+    vector<char> &isGated = scratch.isGated;
+    isGated.assign(size_t(n) * size_t(m), false);
+    for (int i = 0; i < n; ++i) {
+      for (int k = localStart[i]; k < localStart[i + 1]; ++k) {
+        isGated[size_t(i) * size_t(m) + size_t(localCandidates[k])] = true;
+      }
+    }
+
+    // The pairs farther than LO cost more than any assignment of the candidates for the shortest augmenting path, and
+    // are prohibitive for the Hungarian algorithm
+    double farCost = 2e307;
+    if (param_solver == 1) {
+      farCost = 0;
+      for (double a : localCosts) {
+        farCost = std::max(farCost, a);
+      }
+      farCost = farCost * (std::min(n, m) + 1) + 1;
+    }
+    vector<double> &costMatrix = scratch.costMatrix;
+    costMatrix.assign(size_t(n) * size_t(m), farCost);
+    for (int i = 0; i < n; ++i) {
+      for (int k = localStart[i]; k < localStart[i + 1]; ++k) {
+        costMatrix[size_t(i) * size_t(m) + size_t(localCandidates[k])] = localCosts[k];
+      }
+    }
 
-    // Hungarian algorithm to solve the assignment problem O(n**3)
-    HungarianAlgorithm HungAlgo;
-    HungAlgo.Solve(costMatrix, assignment);
+    if (param_solver == 1) {
+      // Dense shortest augmenting path
+      scratch.solver.solveDense(costMatrix, n, m, localAssignment);
+    }
+    else {
+      // Hungarian algorithm to solve the assignment problem O(n**3)
+      scratch.hungarian.Solve(costMatrix.data(), n, m, localAssignment);
+    }
 
     // Finds object that are above the LO limit (+inf columns in the cost matrix
     // Puts the assignment number at -1 to signal new objects
-    for (size_t i = 0; i < assignment.size(); i++) {
-      pair<int, int> p = make_pair(i, assignment[i]);
-      if (find(distances.begin(), distances.end(), p) == distances.end()) {
-        assignment[i] = -1;
+    for (size_t i = 0; i < localAssignment.size(); i++) {
+      if (localAssignment[i] < 0 || !isGated[i * size_t(m) + size_t(localAssignment[i])]) {
+        localAssignment[i] = -1;
       }
     }
   }
 
-  return assignment;
+  for (int i = 0; i < n; ++i) {
+    assignment[rows[i]] = (localAssignment[i] == -1) ? -1 : columns[localAssignment[i]];
+  }
 }
 
 /**
@@ -610,26 +2246,24 @@ vector<int> Tracking::findOcclusion(vector<int> assignment) const {
  * @return The sorted vector.
  */
 vector<Point3d> Tracking::reassignment(const vector<Point3d> &past, const vector<Point3d> &input, const vector<int> &assignment) const {
-  vector<Point3d> tmp = past;
+  vector<Point3d> tmp;
+  tmp.reserve(past.size() + input.size());
+  vector<char> isAssigned(input.size(), false);
 
-  // Reassignes matched object
+  // Reassignes matched object, each position is written once
   for (unsigned int i = 0; i < past.size(); i++) {
     if (assignment[i] != -1) {
-      tmp[i] = input[assignment[i]];
+      tmp.push_back(input[assignment[i]]);
+      isAssigned[assignment[i]] = true;
+    }
+    else {
+      tmp.push_back(past[i]);
     }
   }
 
   // Adds the new objects
-  bool stat;
-  for (int j = 0; j < int(input.size()); j++) {
-    stat = false;
-    for (auto &a : assignment) {
-      if (j == a) {
-        stat = true;
-        break;
-      }
-    }
-    if (!stat) {
+  for (size_t j = 0; j < input.size(); j++) {
+    if (!isAssigned[j]) {
       tmp.push_back(input[j]);
     }
   }
@@ -654,18 +2288,24 @@ void Tracking::cleaning(const vector<int> &occluded, vector<int> &lostCounter, v
     counter[a] = lostCounter[a] + 1;
   }
 
-  // Cleans the data beginning at the start of the vector to keep index in place in the vectors
-  for (size_t i = counter.size(); i > 0; i--) {
-    if (counter.at(i - 1) > param_maximalTime) {
-      counter.erase(counter.begin() + i - 1);
-      id.erase(id.begin() + i - 1);
-      for (size_t j = 0; j < input.size(); j++) {
-        input[j].erase(input[j].begin() + i - 1);
+  // Compacts the objects that are kept in a single pass over each vector, they keep their order
+  auto isKept = [&counter, param_maximalTime](size_t i) { return i >= counter.size() || counter[i] <= param_maximalTime; };
+  auto compact = [&isKept](auto &values) {
+    size_t kept = 0;
+    for (size_t i = 0; i < values.size(); i++) {
+      if (isKept(i)) {
+        values[kept++] = values[i];
       }
     }
+    values.resize(kept);
+  };
+  compact(id);
+  for (auto &a : input) {
+    compact(a);
   }
+  compact(counter);
 
-  lostCounter = counter;
+  lostCounter = std::move(counter);
 }
 
 /**
@@ -674,7 +2314,7 @@ void Tracking::cleaning(const vector<int> &occluded, vector<int> &lostCounter, v
  * @param present: The current position parameters.
  * @return The predicted positions.
  */
-vector<Point3d> Tracking::prevision(vector<Point3d> past, vector<Point3d> present) const {
+vector<Point3d> Tracking::prevision(const vector<Point3d> &past, vector<Point3d> present) const {
   double l = 0;
   for (unsigned int i = 0; i < past.size(); i++) {
     if (past[i] != present[i]) {
@@ -700,47 +2340,21 @@ void Tracking::imageProcessing() {
   while (m_im < m_stopImage) {
     try {
       // Reads the next image in the image sequence and applies the image processing workflow
-      if (!video->getNext(m_visuFrame)) {
+      bool isRead = (param_backend == 2) ? video->getNext(m_frameOcl) : video->getNext(m_frame);
+      if (!isRead) {
         m_error += QString::number(m_im) + ", ";
         m_im++;
         emit(progress(m_im));
         continue;
       }
-      if (param_registration != 0) {
-        registration(m_background, m_visuFrame, param_registration - 1);
-      }
-
-      (statusBinarisation) ? (subtract(m_background, m_visuFrame, m_binaryFrame)) : (subtract(m_visuFrame, m_background, m_binaryFrame));
-      binarisation(m_binaryFrame, 'b', param_thresh);
-
-      if (param_kernelSize != 0 && param_morphOperation != 8) {
-        Mat element = getStructuringElement(param_kernelType, Size(2 * param_kernelSize + 1, 2 * param_kernelSize + 1), Point(param_kernelSize, param_kernelSize));
-        morphologyEx(m_binaryFrame, m_binaryFrame, param_morphOperation, element);
-      }
-
-      if (m_ROI.width != 0 || m_ROI.height != 0) {
-        m_binaryFrame = m_binaryFrame(m_ROI);
-        m_visuFrame = m_visuFrame(m_ROI);
-      }
-
       // Detects the objects and extracts  parameters
-      m_out = objectPosition(m_binaryFrame, param_minArea, param_maxArea);
+      (param_backend == 2) ? processImage(m_frameOcl, m_background) : processImage(m_frame, m_backgroundMat);
 
       // Associates the objets with the previous image
-      vector<int> identity = costFunc(m_outPrev, m_out, param_len, param_angle, param_lo, param_area, param_perimeter);
-      vector<int> occluded = findOcclusion(identity);
-
-      // Reassignes the m_out vector regarding the identities of the objects
-      for (size_t i = 0; i < m_out.size(); i++) {
-        m_out[i] = reassignment(m_outPrev[i], m_out[i], identity);
-      }
+      vector<int> identity = costFunc(m_tracks, m_detections, param_len, param_angle, param_lo, param_area, param_perimeter);
 
-      // Updates id and lost counter
-      while (m_out[0].size() - m_id.size() != 0) {
-        m_idMax++;
-        m_id.push_back(m_idMax);
-        m_lost.push_back(0);
-      }
+      // Updates the tracked objects in place, the new objects are appended with a new id
+      m_tracks.update(m_detections, identity, param_spot, m_idMax);
 
       // Save date in the database
       if (m_im % 50 == 0) {  // Performe the transaction every 50 frames to increase INSERT performance
@@ -748,25 +2362,22 @@ void Tracking::imageProcessing() {
         outputDb.transaction();
       }
       QSqlQuery query(outputDb);
-      for (size_t l = 0; l < m_out[0].size(); l++) {
+      for (size_t l = 0; l < m_tracks.size(); l++) {
         // Tracking data are available
-        if (find(occluded.begin(), occluded.end(), int(l)) == occluded.end()) {
+        if (l >= identity.size() || identity[l] != -1) {
           query.prepare(
               "INSERT INTO tracking (xHead, yHead, tHead, xTail, yTail, tTail, xBody, yBody, tBody, curvature, areaBody, perimeterBody, headMajorAxisLength, headMinorAxisLength, headExcentricity, tailMajorAxisLength, tailMinorAxisLength, tailExcentricity, bodyMajorAxisLength, bodyMinorAxisLength, bodyExcentricity, imageNumber, id) "
               "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-          for (auto const &a : m_out) {
-            query.addBindValue(a[l].x);
-            query.addBindValue(a[l].y);
-            query.addBindValue(a[l].z);
+          for (auto const &a : m_tracks.fields) {
+            query.addBindValue(a[l]);
           }
           query.addBindValue(m_im);
-          query.addBindValue(m_id[l]);
+          query.addBindValue(m_tracks.id[l]);
           query.exec();
         }
       }
 
-      cleaning(occluded, m_lost, m_id, m_out, param_to);
-      m_outPrev = m_out;
+      m_tracks.clean(identity, param_to);
       m_im++;
       emit(progress(m_im));
     }
@@ -842,6 +2453,9 @@ void Tracking::startProcess() {
       throw std::runtime_error("Fatal error, the video can be opened");
     }
 
+    // OpenCV stores the OpenCL activation per thread, the analysis runs in its own thread. If no OpenCL device is available, the OpenCL backend falls back to the CPU.
+    cv::ocl::setUseOpenCL(param_backend == 2);
+
     timer = new QElapsedTimer();
     timer->start();
     m_im = m_startImage;
@@ -863,35 +2477,24 @@ void Tracking::startProcess() {
       }
     }
 
-    // First frame
-    video->getImage(m_im, m_visuFrame);
-
-    (statusBinarisation) ? (subtract(m_background, m_visuFrame, m_binaryFrame)) : (subtract(m_visuFrame, m_background, m_binaryFrame));
-
-    binarisation(m_binaryFrame, 'b', param_thresh);
+    m_background.copyTo(m_backgroundMat);
+    m_coarse.source = nullptr;
+    m_change.source = nullptr;
+    m_tracks.clear();
 
-    if (param_kernelSize != 0 && param_morphOperation != 8) {
-      Mat element = getStructuringElement(param_kernelType, Size(2 * param_kernelSize + 1, 2 * param_kernelSize + 1), Point(param_kernelSize, param_kernelSize));
-      morphologyEx(m_binaryFrame, m_binaryFrame, param_morphOperation, element);
-    }
-
-    if (m_ROI.width != 0) {
-      m_binaryFrame = m_binaryFrame(m_ROI);
-      m_visuFrame = m_visuFrame(m_ROI);
+    // First frame
+    if (param_backend == 2) {
+      video->getImage(m_im, m_frameOcl);
+      processImage(m_frameOcl, m_background);
     }
-
-    m_out = objectPosition(m_binaryFrame, param_minArea, param_maxArea);
-
-    // Assigns an id and a counter at each object detected
-    for (int i = 0; i < static_cast<int>(m_out[0].size()); i++) {
-      m_id.push_back(i);
-      m_lost.push_back(0);
+    else {
+      video->getImage(m_im, m_frame);
+      processImage(m_frame, m_backgroundMat);
     }
 
-    if (!m_id.empty())
-      m_idMax = int(*max_element(m_id.begin(), m_id.end()));
-    else
-      m_idMax = -1;
+    // The objects of the first image are the tracked objects, with the ids 0 to n - 1 and a counter
+    std::swap(m_tracks, m_detections);
+    m_idMax = static_cast<int>(m_tracks.size()) - 1;
 
     //  Creates the folder to save result, parameter and background image
     //  If a folder already exist, renames it with the date and time.
@@ -954,20 +2557,17 @@ void Tracking::startProcess() {
 
     // Saving
     outputDb.transaction();
-    for (size_t l = 0; l < m_out[0].size(); l++) {
+    for (size_t l = 0; l < m_tracks.size(); l++) {
       query.prepare(
           "INSERT INTO tracking (xHead, yHead, tHead, xTail, yTail, tTail, xBody, yBody, tBody, curvature, areaBody, perimeterBody, headMajorAxisLength, headMinorAxisLength, headExcentricity, tailMajorAxisLength, tailMinorAxisLength, tailExcentricity, bodyMajorAxisLength, bodyMinorAxisLength, bodyExcentricity, imageNumber, id) "
           "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-      for (auto const &a : m_out) {
-        query.addBindValue(a[l].x);
-        query.addBindValue(a[l].y);
-        query.addBindValue(a[l].z);
+      for (auto const &a : m_tracks.fields) {
+        query.addBindValue(a[l]);
       }
       query.addBindValue(m_im);
-      query.addBindValue(m_id[l]);
+      query.addBindValue(m_tracks.id[l]);
       query.exec();
     }
-    m_outPrev = m_out;
     m_im++;
     connect(this, &Tracking::finishedProcessFrame, this, &Tracking::imageProcessing);
 
@@ -998,8 +2598,11 @@ void Tracking::updatingParameters(const QMap<QString, QString> &parameterList) {
   param_to = parameterList.value("maxTime").toDouble();
   param_area = parameterList.value("normArea").toDouble();
   param_perimeter = parameterList.value("normPerim").toDouble();
+  m_costNormalizations = {param_len, param_angle, param_area, param_perimeter};
+  m_costTerms = costTerms(m_costNormalizations, m_costWeights);
 
   param_thresh = parameterList.value("thresh").toInt();
+  param_adaptiveThresh = parameterList.value("adaptiveThresh").toInt();
   param_nBackground = parameterList.value("nBack").toDouble();
   param_methodBackground = parameterList.value("methBack").toInt();
   param_methodRegistrationBackground = parameterList.value("regBack").toInt();
@@ -1013,6 +2616,23 @@ void Tracking::updatingParameters(const QMap<QString, QString> &parameterList) {
   param_morphOperation = parameterList.value("morph").toInt();
   param_kernelSize = parameterList.value("morphSize").toInt();
   param_kernelType = parameterList.value("morphType").toInt();
+  param_backend = parameterList.value("backend").toInt();
+  m_isParallel = (param_backend != 1);
+  param_detector = parameterList.value("detector").toInt();
+  param_coarseScale = parameterList.value("coarseScale").toInt();
+  param_n = parameterList.value("nObject").toInt();
+  param_changeTile = parameterList.value("changeTile").toInt();
+  param_solver = parameterList.value("solver").toInt();
+  param_motionGate = parameterList.value("motionGate").toDouble();
+  m_change.source = nullptr;
+  // The features of the spot and the features of the cost function terms used for the matching are always extracted
+  param_features = featureMask(parameterList.value("features")) | ((param_spot == 0) ? FeatureHead : (param_spot == 1) ? FeatureTail : FeatureBody);
+  if (param_area != 0) {
+    param_features |= FeatureArea;
+  }
+  if (param_perimeter != 0) {
+    param_features |= FeaturePerimeter;
+  }
 }
 
 /**
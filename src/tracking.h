@@ -41,10 +41,15 @@ This file is part of Fast Track.
 #include <QTimer>
 #include <QVector>
 #include <algorithm>
+#include <array>
+#include <climits>
+#include <exception>
 #include <fstream>
 #include <iostream>
 #include <numeric>
 #include <opencv2/calib3d.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/core/ocl.hpp>
 #include <opencv2/core/types.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
@@ -53,6 +58,9 @@ This file is part of Fast Track.
 #include <string>
 #include <tuple>
 #include <utility>
+#include "Hungarian.h"
+#include "assignment.h"
+#include "trackstore.h"
 #include "opencv2/features2d/features2d.hpp"
 #include "videoreader.h"
 
@@ -69,6 +77,9 @@ class Tracking : public QObject {
   string m_path;           /*!< Path to an image sequence. */
   string m_backgroundPath; /*!< Path to an image background. */
   UMat m_background;       /*!< Background image CV_8U. */
+  Mat m_backgroundMat;     /*!< Background image CV_8U used by the CPU backends. */
+  Mat m_frame;             /*!< Current image of the sequence read by the CPU backends. */
+  UMat m_frameOcl;         /*!< Current image of the sequence read by the OpenCL backend. */
   int m_displayTime;       /*!< Binary image CV_8U. */
   QString m_savingPath;    /*!< Folder where to save files. */
 
@@ -80,11 +91,10 @@ class Tracking : public QObject {
   Rect m_ROI;                 /*!< Rectangular region of interest. */
   QFile m_logFile;            /*!< Path to the file where to save logs. */
   vector<cv::String> m_files; /*!< Vector containing the path for each image in the images sequence. */
-  vector<int> m_id;           /*!< Vector containing the objets Id. */
-  vector<int> m_lost;         /*!< Vector containing the lost objects. */
   int m_idMax;
+  bool m_isParallel = true;   /*!< False with the single-threaded CPU backend, the parallel loops of this object then run in the calling thread. */
 
-  int param_n;                            /*!< Number of objects. */
+  int param_n;                            /*!< Number of objects, 0 if unknown. If known, only the windows around the previous objects are processed while the tracking is stable. */
   int param_maxArea;                      /*!< Maximal area of an object. */
   int param_minArea;                      /*!< Minimal area of an object. */
   int param_spot;                         /*!< Which spot parameters are used to computes the cost function. 0: head, 1: tail, 2: body. */
@@ -95,6 +105,7 @@ class Tracking : public QObject {
   double param_lo;                        /*!< Maximal distance allowed by an object to travel during an occlusion event. */
   double param_to;                        /*!< Maximal time. */
   int param_thresh;                       /*!< Value of the threshold to binarize the image. */
+  int param_adaptiveThresh;               /*!< Radius of the neighborhood used by the adaptive threshold, 0 to use a global threshold. */
   double param_nBackground;               /*!< Number of images to average to compute the background. */
   int param_methodBackground;             /*!< The method used to compute the background. */
   int param_methodRegistrationBackground; /*!< The method used to register the images for the background. */
@@ -106,9 +117,176 @@ class Tracking : public QObject {
   int param_kernelSize;                   /*!< Size of the kernel of the morphological operation. */
   int param_kernelType;                   /*!< Type of the kernel of the morphological operation. */
   int param_morphOperation;               /*!< Type of the morphological operation. */
+  int param_backend;                      /*!< Compute backend. 0: multi-threaded CPU, 1: single-threaded CPU, 2: OpenCL. */
+  int param_detector;                     /*!< Objects detector. 0: contours, 1: connected components, 2: tiled connected components. */
+  unsigned int param_features;            /*!< Mask of the features extracted for each object, see Tracking::Feature. */
+  int param_coarseScale;                  /*!< Block size of the coarse detection, 0 or 1 to process the whole image. The whole image is also processed if the windows cover more than maxWindowsCoverage of the image. */
+  int param_changeTile;                   /*!< Tile size of the change driven processing, 0 to process every image entirely. */
+  int param_solver;                       /*!< Assignment solver. 0: Hungarian, 1: shortest augmenting path, 2: sparse shortest augmenting path. */
+  double param_motionGate;                /*!< Minimal radius of the gate centred on the predicted position of an object, 0 to use a gate of radius param_lo centred on its previous position. */
   QMap<QString, QString> parameters;      /*!< map of all the parameters for the tracking. */
 
+  /**
+   * @brief Area, bounding box and spatial moments of a connected component, accumulated in one pass over the labels image.
+   */
+  struct Component {
+    int64 m00 = 0, m10 = 0, m01 = 0, m20 = 0, m11 = 0, m02 = 0; /*!< Spatial moments up to the second order in the frame of reference of the image. */
+    int left = INT_MAX, top = INT_MAX, right = -1, bottom = -1; /*!< Bounding box, the right and bottom edges are included. */
+    int firstX = INT_MAX;                                       /*!< x coordinate of the first pixel in the raster order, on the top row. */
+  };
+
+  /**
+   * @brief Object selected by the detector.
+   */
+  struct SelectedObject {
+    int index;   /*!< Index of the contour or of the label. */
+    double area; /*!< Area of the object. */
+    Rect box;    /*!< Bounding box of the object. */
+  };
+
+  /**
+   * @brief Buffers used by one thread to extract the features of an object.
+   */
+  struct ObjectScratch {
+    Mat mask;                          /*!< Buffer where the object is drawn, it grows to the largest bounding box. */
+    vector<vector<Point>> boundary;    /*!< Contour of the object traced to compute the perimeter with the connected components detector. */
+    vector<size_t> boundaryCapacities; /*!< Capacities of the boundary contours, to count the reallocations done by findContours. */
+    size_t allocations = 0;            /*!< Number of buffers allocated by this thread. */
+  };
+
+  /**
+   * @brief Buffers used to label one stripe of the image with the tiled connected components detector.
+   */
+  struct StripeScratch {
+    vector<Component> components; /*!< Connected components of the stripe, indexed by the label in the stripe. */
+    int labelCount = 0;           /*!< Number of labels of the stripe, including the background. */
+    int firstLabel = 0;           /*!< Label of the background of the stripe once the labels of all the stripes are numbered one after the other. */
+    size_t allocations = 0;       /*!< Number of buffers allocated for this stripe. */
+  };
+
+  /**
+   * @brief Scratch buffers of the objects detection, kept alive across images. The buffers are reset at the start of each image but keep their memory, in steady state the detection does not allocate.
+   */
+  struct DetectionArena {
+    vector<vector<Point>> contours;     /*!< Contours of the objects. */
+    vector<size_t> contourCapacities;   /*!< Capacities of the contours, to count the reallocations done by findContours. */
+    Mat labels;                         /*!< Labels of the connected components. */
+    vector<Component> components;       /*!< Connected components, indexed by label. */
+    vector<SelectedObject> selected;    /*!< Objects between the minimal and the maximal area. */
+    vector<array<Point3d, 7>> features; /*!< Features of the selected objects. */
+    vector<ObjectScratch> threads;      /*!< Buffers of each thread extracting the features. */
+    vector<StripeScratch> stripes;      /*!< Buffers of each stripe of the tiled connected components detector. */
+    vector<int> parents;                /*!< Union-find forest linking the labels of the stripes. */
+    vector<int> finalLabels;            /*!< Label of the merged object of each label of the stripes. */
+    size_t allocations = 0;             /*!< Number of buffers allocated by the calling thread. */
+  };
+  mutable DetectionArena m_arena; /*!< Scratch buffers of objectPosition, a Tracking object can not detect objects in two threads at the same time. */
+
+  /**
+   * @brief Buffers of the coarse detection, the pooled background is computed once for each background.
+   */
+  struct CoarseScratch {
+    Mat background;                /*!< Background image pooled by blocks. */
+    const uchar *source = nullptr; /*!< Data of the background image that was pooled, nullptr to pool it again. */
+    int scale = 0;                 /*!< Block size of the pooled background. */
+    bool isDarkObjects = false;    /*!< Pooling of the background, maximum for dark objects and minimum otherwise. */
+    Mat frame;                     /*!< Image pooled by blocks. */
+    Mat candidates;                /*!< Blocks that can contain an object pixel. */
+    Mat labels, stats, centroids;  /*!< Connected components of the candidate blocks. */
+  };
+  mutable CoarseScratch m_coarse; /*!< Buffers of coarseWindows. */
+
+  /**
+   * @brief State of the change driven processing, the binary image and the objects of the tiles that did not change are kept from the previous images.
+   */
+  struct ChangeState {
+    const uchar *source = nullptr;     /*!< Data of the background image of the state, nullptr to process the next image entirely. */
+    Mat reference;                     /*!< Image at the last processing of each tile. */
+    Mat threshold;                     /*!< Binary image before the morphological operation. */
+    Mat tolerance;                     /*!< Smallest change of a pixel of each tile that can change the binary image. */
+    Mat difference, pooled, changed;   /*!< Change of each pixel and of each tile, changed tiles. */
+    Mat above, below, morphed;         /*!< Buffers of the processing of the changed tiles. */
+    Mat labels, stats, centroids;      /*!< Groups of changed tiles. */
+    vector<Rect> tiles;                /*!< Groups of changed tiles. */
+    vector<Rect> boxes;                /*!< Bounding boxes of all the objects of the binary image, including the objects filtered by their area. */
+    vector<array<Point3d, 7>> objects; /*!< Features of the detected objects, see objectPosition. */
+    vector<Rect> objectBoxes;          /*!< Bounding boxes of the detected objects. */
+  };
+  ChangeState m_change; /*!< State of processChanges, the boxes are in the frame of reference of the region of interest. */
+
+  /**
+   * @brief Solvers and buffers of one thread solving the components of the assignment problem in costFunc, kept alive across images.
+   */
+  struct AssignmentScratch {
+    Assignment solver;                /*!< Shortest augmenting path solvers. */
+    HungarianAlgorithm hungarian;     /*!< Hungarian solver. */
+    vector<int> rowStart, candidates; /*!< Candidates of the component. */
+    vector<double> costs;             /*!< Costs of the candidates of the component. */
+    vector<double> costMatrix;        /*!< Dense cost matrix of the component in row major order. */
+    vector<char> isGated;             /*!< Pairs of the component closer than LO in row major order. */
+    vector<int> assignment;           /*!< Assignment of the component. */
+  };
+  /**
+   * @brief Buffers of costFunc, kept alive across images. The buffers keep their memory, in steady state the matching does not allocate.
+   */
+  struct CostScratch {
+    vector<pair<pair<int64, int64>, int>> cells;        /*!< Cell of each current object, sorted by cell. */
+    vector<double> x, y, angle, area, perimeter;        /*!< Features of the current objects in the order of the cells, empty for the unused terms. */
+    vector<double> rowDistance, rowCost;                /*!< Distances and costs between a previous object and a row of cells. */
+    vector<int> rowStart, candidates;                   /*!< Candidates of each previous object. */
+    vector<double> costs;                               /*!< Costs of the candidates. */
+    vector<int> parents;                                /*!< Union-find forest of the previous and current objects. */
+    vector<int> componentOf;                            /*!< Component of each root of the forest, -1 for the objects without candidate. */
+    vector<int> componentRowStart, componentRows;       /*!< Previous objects of each component. */
+    vector<int> componentColumnStart, componentColumns; /*!< Current objects of each component. */
+    vector<int> localColumns;                           /*!< Index of each current object in its component. */
+  };
+  mutable CostScratch m_costScratch;               /*!< Buffers of costFunc, a Tracking object can not match objects in two threads at the same time. */
+  mutable vector<AssignmentScratch> m_assignments; /*!< Buffers of each thread in costFunc. */
+
+  array<double, 4> m_costNormalizations = {NAN, NAN, NAN, NAN}; /*!< Normalizations of the distance, angle, area and perimeter terms of the cost function selected by updatingParameters. */
+  array<double, 4> m_costWeights = {0, 0, 0, 0};                /*!< Reciprocals of the normalizations, 0 for the unused terms. */
+  int m_costTerms = 0;                                          /*!< Used terms of the cost function, the costFunc kernel is instantiated for each combination of terms. */
+
+  Mat m_binary;                        /*!< Binary image CV_8U of the whole image when only windows are processed, zero outside the windows except with the change driven processing. */
+  vector<Rect> m_processedWindows;     /*!< Windows of m_binary written by the last image. */
+  bool m_isWindowed = false;           /*!< True if only the windows of the last image were processed. */
+  bool m_isPredicted = false;          /*!< True if the windows of the last image are the windows around the previous objects. */
+  bool m_isIncremental = false;        /*!< True if the windows of the last image are the windows around the changes, the objects outside the windows are kept. */
+  vector<Rect> m_windows;              /*!< Windows of the binary image where the objects are detected if m_isWindowed is true. */
+  vector<vector<Point3d>> m_windowOut; /*!< Objects detected in one window. */
+
+  bool processWindows(const Mat &frame, const Mat &background, const Mat &element, int margin, bool isChecked);
+  void processChanges(const Mat &frame, const Mat &background, const Mat &element);
+  template <typename T>
+  void preprocessing(const T &frame, const T &background, bool isPredicted);
+  template <unsigned int Features>
+  array<Point3d, 7> objectFeatures(const Mat &object, const Moments &moment, const Point &offset, double area, double perimeter) const;
+  template <unsigned int Features, typename Output>
+  void objectPosition(const Mat &frame, int minSize, int maxSize, int detector, Output &out) const;
+  template <typename Output>
+  void selectObjectPosition(const Mat &frame, int minSize, int maxSize, int detector, unsigned int features, Output &out) const;
+  static void componentStats(const Mat &labels, int rowOffset, vector<Component> &components);
+  int labelComponents(const Mat &frame, int detector) const;
+  void detectionBoxes(int detector, const Point &offset, vector<Rect> &objects, vector<Rect> &components) const;
+  void growWindows(vector<Rect> &windows) const;
+  void detectObjects(TrackStore &out);
+  void assignComponent(const int *rows, int n, const int *columns, int m, const vector<int> &localColumns, const vector<int> &rowStart, const vector<int> &candidates, const vector<double> &costs, AssignmentScratch &scratch, vector<int> &assignment) const;
+
  public:
+  /**
+   * @brief Features extracted for each object, combined in a mask. The features that are not extracted are set to 0.
+   */
+  enum Feature : unsigned int {
+    FeatureHead = 1 << 0,      /*!< Head position, direction and ellipse. */
+    FeatureTail = 1 << 1,      /*!< Tail position, direction and ellipse. */
+    FeatureBody = 1 << 2,      /*!< Body position, direction and ellipse. */
+    FeatureCurvature = 1 << 3, /*!< Curvature, needs the head and the tail. */
+    FeatureArea = 1 << 4,      /*!< Area. */
+    FeaturePerimeter = 1 << 5, /*!< Perimeter. */
+    FeatureAll = (1 << 6) - 1  /*!< All the features. */
+  };
+
   Tracking() = default;
   Tracking(string path, string background, int startImage = 0, int stopImage = -1);
   Tracking(string path, UMat background, int startImage = 0, int stopImage = -1);
@@ -118,28 +296,45 @@ class Tracking : public QObject {
 
   const QString connectionName;
   Point2d curvatureCenter(const Point3d &tail, const Point3d &head) const;
-  double curvature(Point2d center, const Mat &image) const;
+  double curvature(Point2d center, const Mat &image, bool isParallel = true) const;
   double divide(double a, double b) const;
-  bool objectDirection(const UMat &image, vector<double> &information) const;
-  vector<double> objectInformation(const UMat &image) const;
+  bool objectDirection(InputArray image, vector<double> &information) const;
+  static bool projectionDirection(const vector<double> &projection);
+  vector<double> objectInformation(InputArray image) const;
+  vector<double> objectInformation(const Moments &moment) const;
   vector<Point3d> reassignment(const vector<Point3d> &past, const vector<Point3d> &input, const vector<int> &assignment) const;
-  vector<vector<Point3d>> objectPosition(const UMat &frame, int minSize, int maxSize) const;
+  vector<vector<Point3d>> objectPosition(const Mat &frame, int minSize, int maxSize, int detector = 0, unsigned int features = FeatureAll) const;
+  void objectPosition(const Mat &frame, int minSize, int maxSize, int detector, unsigned int features, vector<vector<Point3d>> &out) const;
+  void objectPosition(const Mat &frame, int minSize, int maxSize, int detector, unsigned int features, TrackStore &out) const;
+  size_t detectionAllocations() const;
+  bool coarseWindows(const Mat &frame, const Mat &background, bool isDarkObjects, int value, int scale, int margin, vector<Rect> &windows) const;
+  template <typename T>
+  void processImage(T &frame, const T &background);
+  bool predictionWindows(const TrackStore &objects, int spot, double maxDistance, const Point &offset, const Size &size, int margin, vector<Rect> &windows) const;
   vector<int> costFunc(const vector<vector<Point3d>> &prevPos, const vector<vector<Point3d>> &pos, double LENGHT, double ANGLE, double LO, double AREA, double PERIMETER) const;
+  vector<int> costFunc(const TrackStore &prevPos, const TrackStore &pos, double LENGHT, double ANGLE, double LO, double AREA, double PERIMETER) const;
   void cleaning(const vector<int> &occluded, vector<int> &lostCounter, vector<int> &id, vector<vector<Point3d>> &input, double param_maximalTime) const;
-  vector<Point3d> prevision(vector<Point3d> past, vector<Point3d> present) const;
+  vector<Point3d> prevision(const vector<Point3d> &past, vector<Point3d> present) const;
   vector<int> findOcclusion(vector<int> assignment) const;
   static double modul(double angle);
   static double angleDifference(double alpha, double beta);
   static UMat backgroundExtraction(VideoReader &video, int n, const int method, const int registrationMethod);
   static void registration(UMat imageReference, UMat &frame, int method);
+  static void registration(Mat imageReference, Mat &frame, int method);
   static void binarisation(UMat &frame, char backgroundColor, int value);
+  static void binarisation(Mat &frame, char backgroundColor, int value);
+  static void adaptiveBinarisation(UMat &frame, int radius, int offset, bool isParallel = true);
+  static void adaptiveBinarisation(Mat &frame, int radius, int offset, bool isParallel = true);
+  static void adaptiveBinarisation(const UMat &image, const UMat &subtrahend, UMat &binary, int radius, int offset, bool isParallel = true);
+  static void adaptiveBinarisation(const Mat &image, const Mat &subtrahend, Mat &binary, int radius, int offset, bool isParallel = true);
+  static unsigned int featureMask(const QString &features);
   static bool exportTrackingResult(const QString path, QSqlDatabase db);
   static bool importTrackingResult(const QString path, QSqlDatabase db);
 
-  UMat m_binaryFrame;                /*!< Binary image CV_8U */
-  UMat m_visuFrame;                  /*!< Image 8 bit CV_8U */
-  vector<vector<Point3d>> m_out;     /*!< Objects information at iteration minus one */
-  vector<vector<Point3d>> m_outPrev; /*!< Objects information at current iteration */
+  Mat m_binaryFrame;       /*!< Binary image CV_8U */
+  Mat m_visuFrame;         /*!< Image 8 bit CV_8U */
+  TrackStore m_detections; /*!< Objects detected in the current image, written directly by the detection with the ids 0 to n - 1. */
+  TrackStore m_tracks;     /*!< Tracked objects with their id and lost counter, updated in place at each image. */
 
  public slots:
   virtual void startProcess();
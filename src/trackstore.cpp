@@ -0,0 +1,175 @@
+/*
+This file is part of Fast Track.
+
+    FastTrack is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastTrack is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastTrack.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "trackstore.h"
+
+/**
+ * @class TrackStore
+ *
+ * @brief Stores the objects features as a structure of arrays, one contiguous array per feature. Each tracked object keeps its slot from one image to the next, the new objects are appended and the slots are only compacted when lost objects are removed. A constant velocity model of each object predicts its next position.
+ */
+
+/**
+ * @brief Removes all the objects, the arrays keep their memory.
+ */
+void TrackStore::clear() {
+  for (auto &a : fields) {
+    a.clear();
+  }
+  id.clear();
+  lost.clear();
+  vx.clear();
+  vy.clear();
+  error.clear();
+}
+
+/**
+ * @brief Loads the objects detected by Tracking::objectPosition, the objects are given the ids 0 to n - 1.
+ * @param[in] objects Features of the objects, 7 vectors of Point3d: head, tail and body positions, curvature area and perimeter, head, tail and body ellipses. The missing or empty vectors are loaded as zeros.
+ */
+void TrackStore::load(const vector<vector<cv::Point3d>> &objects) {
+  size_t n = objects.empty() ? 0 : objects[0].size();
+  for (size_t k = 0; k < fieldCount / 3; k++) {
+    vector<double> &a = fields[3 * k], &b = fields[3 * k + 1], &c = fields[3 * k + 2];
+    a.resize(n);
+    b.resize(n);
+    c.resize(n);
+    bool isLoaded = k < objects.size() && objects[k].size() == n;
+    for (size_t i = 0; i < n; i++) {
+      const cv::Point3d point = isLoaded ? objects[k][i] : cv::Point3d(0, 0, 0);
+      a[i] = point.x;
+      b[i] = point.y;
+      c[i] = point.z;
+    }
+  }
+  id.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    id[i] = static_cast<int>(i);
+  }
+  lost.assign(n, 0);
+  vx.assign(n, 0);
+  vy.assign(n, 0);
+  error.assign(n, INFINITY);
+}
+
+/**
+ * @brief Appends a detected object, the object is given the id of its slot.
+ * @param[in] object Features of the object in the order of Tracking::objectPosition: head, tail and body positions, curvature area and perimeter, head, tail and body ellipses.
+ */
+void TrackStore::push_back(const array<cv::Point3d, 7> &object) {
+  for (size_t k = 0; k < fieldCount / 3; k++) {
+    fields[3 * k].push_back(object[k].x);
+    fields[3 * k + 1].push_back(object[k].y);
+    fields[3 * k + 2].push_back(object[k].z);
+  }
+  id.push_back(static_cast<int>(id.size()));
+  lost.push_back(0);
+  vx.push_back(0);
+  vy.push_back(0);
+  error.push_back(INFINITY);
+}
+
+/**
+ * @brief Updates the objects with the detections of the current image. The detection assignment[i] is written in the slot i, the detections that are not assigned are appended as new objects. The velocity of a matched object is its displacement per image since its last detection, the squared error of its prediction is added to an exponential moving average of decay errorDecay.
+ * @param[in] detections Objects detected in the current image.
+ * @param[in] assignment Detection assigned to each slot, -1 if the object was not found.
+ * @param[in] spot Part of the object used for the motion model. 0: head, 1: tail, 2: body.
+ * @param[in, out] idMax Largest id given to an object, incremented for each new object.
+ */
+void TrackStore::update(const TrackStore &detections, const vector<int> &assignment, int spot, int &idMax) {
+  size_t m = detections.size();
+  isAssigned.assign(m, false);
+  const vector<double> &previousX = x(spot), &previousY = y(spot), &currentX = detections.x(spot), &currentY = detections.y(spot);
+  for (size_t i = 0; i < assignment.size(); i++) {
+    if (assignment[i] != -1) {
+      isAssigned[assignment[i]] = true;
+
+      // Images since the last detection, the object was predicted at constant velocity during this time
+      double time = lost[i] + 1;
+      double dx = currentX[assignment[i]] - previousX[i];
+      double dy = currentY[assignment[i]] - previousY[i];
+      double squaredError = pow(dx - vx[i] * time, 2) + pow(dy - vy[i] * time, 2);
+      error[i] = std::isinf(error[i]) ? squaredError : errorDecay * error[i] + (1 - errorDecay) * squaredError;
+      vx[i] = dx / time;
+      vy[i] = dy / time;
+    }
+  }
+
+  for (size_t f = 0; f < fieldCount; f++) {
+    vector<double> &field = fields[f];
+    const vector<double> &detected = detections.fields[f];
+    for (size_t i = 0; i < assignment.size(); i++) {
+      if (assignment[i] != -1) {
+        field[i] = detected[assignment[i]];
+      }
+    }
+    for (size_t j = 0; j < m; j++) {
+      if (!isAssigned[j]) {
+        field.push_back(detected[j]);
+      }
+    }
+  }
+
+  for (size_t j = 0; j < m; j++) {
+    if (!isAssigned[j]) {
+      idMax++;
+      id.push_back(idMax);
+      lost.push_back(0);
+      vx.push_back(0);
+      vy.push_back(0);
+      error.push_back(INFINITY);
+    }
+  }
+}
+
+/**
+ * @brief Counts the images where each object was not found and removes the objects lost more than a certain time. The remaining objects keep their order.
+ * @param[in] assignment Detection assigned to each slot before the update, -1 if the object was not found.
+ * @param[in] maximalTime Maximal number of consecutive images an object can be lost.
+ */
+void TrackStore::clean(const vector<int> &assignment, double maximalTime) {
+  size_t n = size();
+  for (size_t i = 0; i < n; i++) {
+    lost[i] = (i < assignment.size() && assignment[i] == -1) ? lost[i] + 1 : 0;
+  }
+
+  // Compacts the slots of the objects that are kept in a single pass
+  size_t kept = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (lost[i] <= maximalTime) {
+      if (kept != i) {
+        for (auto &a : fields) {
+          a[kept] = a[i];
+        }
+        id[kept] = id[i];
+        lost[kept] = lost[i];
+        vx[kept] = vx[i];
+        vy[kept] = vy[i];
+        error[kept] = error[i];
+      }
+      kept++;
+    }
+  }
+  for (auto &a : fields) {
+    a.resize(kept);
+  }
+  id.resize(kept);
+  lost.resize(kept);
+  vx.resize(kept);
+  vy.resize(kept);
+  error.resize(kept);
+}
@@ -0,0 +1,81 @@
+/*
+This file is part of Fast Track.
+
+    FastTrack is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastTrack is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastTrack.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACKSTORE_H
+#define TRACKSTORE_H
+
+#include <array>
+#include <cmath>
+#include <opencv2/core/types.hpp>
+#include <vector>
+
+using namespace std;
+
+class TrackStore {
+ public:
+  /**
+   * @brief Features of an object, in the order of the columns of the tracking table.
+   */
+  enum Field {
+    xHead,
+    yHead,
+    tHead,
+    xTail,
+    yTail,
+    tTail,
+    xBody,
+    yBody,
+    tBody,
+    curvature,
+    areaBody,
+    perimeterBody,
+    headMajorAxisLength,
+    headMinorAxisLength,
+    headExcentricity,
+    tailMajorAxisLength,
+    tailMinorAxisLength,
+    tailExcentricity,
+    bodyMajorAxisLength,
+    bodyMinorAxisLength,
+    bodyExcentricity,
+    fieldCount
+  };
+
+  array<vector<double>, fieldCount> fields; /*!< One contiguous array per feature, indexed by the slot of the object. */
+  vector<int> id;                           /*!< Id of the object of each slot. */
+  vector<int> lost;                         /*!< Number of consecutive images where the object of each slot was not found. */
+  vector<double> vx, vy;                    /*!< Velocity of the matched part of the object of each slot in pixels per image. */
+  vector<double> error;                     /*!< Exponential moving average of the squared errors of the predicted positions of the object of each slot, infinite until the object is matched once. */
+
+  static constexpr double errorDecay = 0.5; /*!< Weight of the previous average in the moving average of the squared prediction errors, the weight of an error is halved at each detection. */
+
+  TrackStore() = default;
+  size_t size() const { return id.size(); }
+  const vector<double> &x(int spot) const { return fields[3 * spot]; }
+  const vector<double> &y(int spot) const { return fields[3 * spot + 1]; }
+  const vector<double> &angle(int spot) const { return fields[3 * spot + 2]; }
+  void clear();
+  void load(const vector<vector<cv::Point3d>> &objects);
+  void push_back(const array<cv::Point3d, 7> &object);
+  void update(const TrackStore &detections, const vector<int> &assignment, int spot, int &idMax);
+  void clean(const vector<int> &assignment, double maximalTime);
+
+ private:
+  vector<char> isAssigned; /*!< Detections assigned to a slot in update, reused across images. */
+};
+
+#endif